@@ -10,11 +10,14 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <utility>
 
 #include "module_traits.hpp"
 #include "money.hpp"
 #include "date.hpp"
+#include "data_range.hpp"
 #include "writer_fwd.hpp"
+#include "snapshot_fwd.hpp"
 
 namespace budget {
 
@@ -65,6 +68,9 @@ void operator>>(const std::vector<std::string>& parts, asset& asset);
 std::ostream& operator<<(std::ostream& stream, const asset_value& asset);
 void operator>>(const std::vector<std::string>& parts, asset_value& asset);
 
+snapshot_writer& operator<<(snapshot_writer& writer, const asset_value& asset_value);
+snapshot_reader& operator>>(snapshot_reader& reader, asset_value& asset_value);
+
 void load_assets();
 void save_assets();
 
@@ -73,7 +79,12 @@ void list_asset_values(budget::writer& w);
 void small_show_asset_values(budget::writer& w);
 void show_asset_values(budget::writer& w);
 void show_asset_portfolio(budget::writer& w);
-void show_asset_rebalance(budget::writer& w);
+
+/*!
+ * \brief Display the trades needed to rebalance the portfolio, after
+ * investing the given new money (or withdrawing, if it is negative).
+ */
+void show_asset_rebalance(budget::writer& w, budget::money new_money = budget::money());
 
 bool asset_exists(const std::string& asset);
 
@@ -88,6 +99,23 @@ std::vector<budget::asset>& all_assets();
 std::vector<budget::asset_value>& all_asset_values();
 std::vector<budget::asset_value> all_sorted_asset_values();
 
+/*!
+ * \brief Returns the values of the given asset, sorted by date.
+ */
+budget::data_range<budget::asset_value> sorted_asset_values(size_t asset_id);
+
+/*!
+ * \brief Find the latest value of the given asset.
+ * \return a pair (found, id of the asset value)
+ */
+std::pair<bool, size_t> find_last_asset_value(size_t asset_id);
+
+/*!
+ * \brief Find the latest value of the given asset at the given date.
+ * \return a pair (found, id of the asset value)
+ */
+std::pair<bool, size_t> find_last_asset_value(size_t asset_id, budget::date d);
+
 void set_assets_next_id(size_t next_id);
 void set_asset_values_next_id(size_t next_id);
 
@@ -96,12 +124,33 @@ void set_asset_values_changed();
 
 std::string get_default_currency();
 
+/*!
+ * \brief Obtain the exchange rates of all the assets at once, before
+ * they are converted to the default currency.
+ */
+void prefetch_asset_exchange_rates();
+
+/*!
+ * \brief Obtain the missing current exchange rates of the assets and their
+ * missing historical rates, since their first value.
+ *
+ * The data is only read at the beginning, under the lock of the server.
+ * The rates are then obtained from the network, which can take a long
+ * time, this should only be done in the background.
+ */
+void fetch_asset_exchange_rates();
+
 void add_asset(asset&& asset);
 bool asset_exists(size_t id);
 void asset_delete(size_t id);
 asset& asset_get(size_t id);
 
 void add_asset_value(asset_value&& asset_value);
+
+/*!
+ * \brief Adds all the given asset values at once and returns their ids.
+ */
+std::vector<size_t> add_asset_values(std::vector<asset_value>&& asset_values);
 bool asset_value_exists(size_t id);
 void asset_value_delete(size_t id);
 asset_value& asset_value_get(size_t id);
@@ -112,4 +161,23 @@ budget::money get_net_worth_cash();
 
 budget::money get_net_worth(budget::date d);
 
+/*!
+ * \brief The net worth at a given date.
+ */
+struct net_worth_point {
+    budget::date date;
+    budget::money net_worth;
+    budget::money portfolio;
+    budget::money cash;
+};
+
+/*!
+ * \brief Computes the net worth, the portfolio and the cash at each date
+ * where the value of an asset changes.
+ *
+ * The sorted asset values are swept only once. The amounts are converted
+ * with the exchange rates of each date.
+ */
+std::vector<net_worth_point> net_worth_series();
+
 } //end of namespace budget
@@ -0,0 +1,26 @@
+//=======================================================================
+// Copyright (c) 2013-2018 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+#include <string>
+
+namespace budget {
+
+/*!
+ * \brief Compress the given data in the gzip format.
+ * \return true if the data could be compressed, false otherwise.
+ */
+bool gzip_compress(const std::string& data, std::string& compressed);
+
+/*!
+ * \brief Decompress the given data in the gzip format.
+ * \return true if the data could be decompressed, false otherwise.
+ */
+bool gzip_decompress(const std::string& compressed, std::string& data);
+
+} //end of namespace budget
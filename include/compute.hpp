@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "money.hpp"
 #include "date.hpp"
 
@@ -49,4 +51,56 @@ status compute_avg_month_status();
 status compute_avg_month_status(budget::month year);
 status compute_avg_month_status(budget::year year, budget::month month);
 
+/*!
+ * \brief The income, expenses and savings rate of each month of a period,
+ * stored as dense arrays.
+ *
+ * The income is made of the accounts and the earnings of the month. The
+ * totals over windows of months are computed with prefix sums.
+ */
+struct monthly_history {
+    budget::date first; // The first month of the period
+
+    std::vector<budget::money> income;
+    std::vector<budget::money> expenses;
+    std::vector<double> savings_rate; // Never negative
+
+    size_t size() const {
+        return income.size();
+    }
+
+    /*!
+     * \brief Returns the first day of the ith month of the period.
+     */
+    budget::date month_date(size_t i) const {
+        return first + budget::months(i);
+    }
+
+    /*!
+     * \brief Returns the total of the expenses of the months [first, last).
+     */
+    budget::money total_expenses(size_t first, size_t last) const {
+        return expenses_sums[last] - expenses_sums[first];
+    }
+
+    /*!
+     * \brief Returns the average savings rate of the months [first, last).
+     */
+    double average_savings_rate(size_t first, size_t last) const {
+        return (savings_rate_sums[last] - savings_rate_sums[first]) / double(last - first);
+    }
+
+private:
+    std::vector<budget::money> expenses_sums; // expenses_sums[i] is the total of the i first months
+    std::vector<double> savings_rate_sums;    // savings_rate_sums[i] is the total of the i first months
+
+    friend monthly_history compute_monthly_history(budget::date from, budget::date to);
+};
+
+/*!
+ * \brief Computes the history of each month between the months of the
+ * two given dates (inclusive).
+ */
+monthly_history compute_monthly_history(budget::date from, budget::date to);
+
 } //end of namespace budget
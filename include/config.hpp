@@ -28,6 +28,15 @@ bool internal_config_contains(const std::string& key);
 std::string& internal_config_value(const std::string& key);
 void internal_config_remove(const std::string& key);
 
+/*!
+ * \brief Pin a copy of the internal configuration for the calling thread.
+ *
+ * Until it is unpinned, the calling thread does not see the modifications
+ * made by other threads.
+ */
+void pin_internal_config();
+void unpin_internal_config();
+
 std::string get_web_user();
 std::string get_web_password();
 
@@ -67,4 +76,31 @@ bool is_fortune_disabled();
  */
 bool net_worth_over_fortune();
 
+/*!
+ * \brief The level of durability of the saved data.
+ */
+enum class durability {
+    none,  ///< The data is never flushed to the disk
+    batch, ///< The data is flushed to the disk after each save of a file
+    write  ///< The data is flushed to the disk after each modification
+};
+
+/*!
+ * \brief Returns the level of durability of the saved data.
+ *
+ * This can be changed with data_durability=none|batch|write in the
+ * configuration file. By default, each saved file is flushed to the
+ * disk.
+ */
+durability get_durability();
+
+/*!
+ * \brief Returns the number of records of the journal after which the
+ * server compacts it into the data file.
+ *
+ * This can be changed with journal_compaction=N in the configuration
+ * file. By default, the journal is compacted every 1000 records.
+ */
+size_t journal_compaction_threshold();
+
 } //end of namespace budget
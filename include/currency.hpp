@@ -8,12 +8,131 @@
 #pragma once
 
 #include <string>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+
+#include "date.hpp"
+#include "money.hpp"
 
 namespace budget {
 
+/*!
+ * \brief A source of exchange rates.
+ */
+struct exchange_rate_provider {
+    virtual ~exchange_rate_provider() = default;
+
+    /*!
+     * \brief Get the exchange rate between the two currencies at the given date.
+     *
+     * This can be called concurrently for several pairs.
+     *
+     * \return true if the rate could be obtained, false otherwise
+     */
+    virtual bool get_rate(const std::string& from, const std::string& to, budget::date date, double& rate) = 0;
+
+    /*!
+     * \brief Add to the given vector the (date, rate) pairs of the two
+     * currencies that are available without accessing the network.
+     */
+    virtual void local_rates(const std::string& /*from*/, const std::string& /*to*/, std::vector<std::pair<budget::date, double>>& /*rates*/) {
+        // By default, no rates are available locally
+    }
+};
+
+/*!
+ * \brief Change the source of the exchange rates.
+ *
+ * By default, the rates are fetched from free.currencyconverterapi.com,
+ * or read from a local file if exchange_rates_file=path is set in the
+ * configuration. The file contains lines in the form from:to:date:rate.
+ */
+void set_exchange_rate_provider(std::unique_ptr<exchange_rate_provider> provider);
+
 double exchange_rate(const std::string& from);
 double exchange_rate(const std::string& from, const std::string& to);
 
+/*!
+ * \brief Converts the amount to the given currency (the default currency
+ * by default), at the current rate, rounded to the nearest cent.
+ */
+budget::money convert(budget::money amount, const std::string& from);
+budget::money convert(budget::money amount, const std::string& from, const std::string& to);
+
+/*!
+ * \brief Obtain all the given exchange rates that are not cached yet.
+ *
+ * The missing rates are fetched concurrently, so that they can then be
+ * used without waiting for the provider one pair at a time.
+ */
+void prefetch_exchange_rates(const std::vector<std::pair<std::string, std::string>>& pairs);
+
+/*!
+ * \brief Obtain the missing historical exchange rates between the two
+ * currencies, on the first day of each month since the given date.
+ *
+ * The rates are obtained one by one from the provider and then cached.
+ * This can access the network many times and should only be done in the
+ * background.
+ */
+void fetch_exchange_rate_history(const std::string& from, const std::string& to, budget::date first);
+
+/*!
+ * \brief Returns the exchange rate between the two currencies at the given date.
+ *
+ * The rate is interpolated between the known rates of the pair. Before
+ * the first known rate and after the last one, the closest one is used.
+ */
+double exchange_rate(const std::string& from, const std::string& to, budget::date d);
+
+/*!
+ * \brief The known exchange rates of a currency pair over time.
+ *
+ * The rates are collected once from the cache and the provider, without
+ * fetching the history. When no rate of the history is known, the current
+ * rate of the pair is used at all dates. The rate at any date can then be
+ * computed without locking.
+ */
+struct exchange_rate_history {
+    exchange_rate_history(const std::string& from, const std::string& to);
+
+    /*!
+     * \brief Returns the rate at the given date, interpolated between the
+     * two closest known rates.
+     */
+    double rate(budget::date d) const;
+
+private:
+    std::vector<std::pair<long, double>> points; // (day number, rate), sorted by day
+    double default_rate = 1.0;                   // When no rate of the history is known
+};
+
+/*!
+ * \brief Converts amounts of several currencies to the default currency,
+ * at any date.
+ *
+ * The history of each currency is collected the first time it is needed.
+ * This should be used to convert a series of values.
+ */
+struct currency_converter {
+    double rate(const std::string& currency, budget::date d);
+
+    budget::money convert(budget::money amount, const std::string& currency, budget::date d) {
+        return budget::multiply(amount, budget::fixed_rate(rate(currency, d)));
+    }
+
+private:
+    std::unordered_map<std::string, exchange_rate_history> histories;
+};
+
+/*!
+ * \brief Mark the cached exchange rates as stale.
+ *
+ * The stale rates are still used, but are refreshed in the background
+ * the next time they are needed.
+ */
 void invalidate_currency_cache();
 
 } //end of namespace budget
@@ -7,22 +7,107 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
 #include "cpp_utils/assert.hpp"
 
 #include "config.hpp"
+#include "date.hpp"
+#include "data_store.hpp"
+#include "snapshot.hpp"
 #include "utils.hpp"
 #include "server.hpp"
 #include "api.hpp"
 
 namespace budget {
 
+/*!
+ * \brief Pins the current version of the data of all the modules for the
+ * calling thread.
+ *
+ * As long as the object is alive, the data handlers return an immutable
+ * copy of their data to the calling thread. The modifications made in
+ * the meantime by other threads publish a new version and are not
+ * visible. The data must not be modified while being pinned.
+ *
+ * The pinned versions are shared between the threads and with the
+ * writers, the data is only copied when it is modified while still
+ * pinned.
+ */
+struct pinned_data {
+    pinned_data();
+    ~pinned_data();
+
+    pinned_data(const pinned_data& rhs) = delete;
+    pinned_data& operator=(const pinned_data& rhs) = delete;
+};
+
+/*!
+ * \brief Register the functions to pin and unpin the data of a module,
+ * to get its pinned version and to write its changes since a version.
+ */
+void register_data_handler(const char* module, std::function<void()> pin, std::function<void()> unpin,
+                           std::function<size_t()> version, std::function<void(std::ostream&, size_t)> changes);
+
+/*!
+ * \brief Returns the identifier of the versions of the data.
+ *
+ * The versions are only comparable with the same epoch, a new epoch is
+ * used each time the server is started.
+ */
+const std::string& data_epoch();
+
+/*!
+ * \brief Returns the version of the data of the given module pinned by
+ * the calling thread.
+ */
+size_t module_version(const std::string& module);
+
+/*!
+ * \brief Writes the entries of the given module that have been added,
+ * edited or deleted since the given version. The data must be pinned by
+ * the calling thread.
+ *
+ * The first line is version:delta, followed by the modified entries and
+ * the ids of the deleted entries, prefixed by -. When the changes since
+ * the given version are not known, the first line is version:full,
+ * followed by all the entries.
+ *
+ * \return false if there is no such module.
+ */
+bool write_module_changes(const std::string& module, std::ostream& out, size_t since);
+
+/*!
+ * \brief Gives the rows of the given module, as obtained from the server,
+ * to the parse function (server mode only).
+ *
+ * The rows of all the modules are obtained with a single request, the
+ * first time this is called. The rows of each module can only be
+ * obtained once, after that, or if the server does not support it, false
+ * is returned and the module must be loaded with its own API.
+ *
+ * The parse function also receives the version of the rows
+ * (epoch:version).
+ */
+bool load_synced_rows(const std::string& module, const std::function<void(const char*, const char*, const std::string&)>& parse);
+
 template<typename T>
 struct data_handler {
     size_t next_id;
-    std::vector<T> data;
 
     data_handler(const char* module, const char* path) : module(module), path(path) {
-        // Nothing else to init
+        register_data_handler(module,
+                              [this]() { pin(); },
+                              [this]() { unpin(); },
+                              [this]() { return pinned_version; },
+                              [this](std::ostream& out, size_t since) { write_changes(out, since); });
     };
 
     //data_handler should never be copied
@@ -33,26 +118,89 @@ struct data_handler {
         return changed;
     }
 
+    /*!
+     * \brief Returns the entries of the module.
+     *
+     * When the calling thread has pinned the data, this is the pinned
+     * version of the entries, which must not be modified.
+     */
+    std::vector<T>& data() {
+        return current().entries;
+    }
+
     void set_changed() {
-        if (is_server_running()) {
-            force_save();
-        } else {
-            changed = true;
+        cpp_assert(!pinned, "The pinned data cannot be modified");
+
+        // The entries may have been modified directly
+        writable().invalidate_indexes();
+        ++version;
+
+        reset_changes();
+
+        mark_changed();
+    }
+
+    /*!
+     * \brief Split each non-empty line of the buffer into its fields and
+     * call the functor with them.
+     */
+    template<typename Functor>
+    static void for_each_line(const char* first, const char* last, Functor f){
+        // The fields are reused from line to line to avoid allocations
+        std::vector<std::string> parts;
+
+        while (first != last) {
+            auto end_of_line = static_cast<const char*>(std::memchr(first, '\n', last - first));
+
+            if (!end_of_line) {
+                end_of_line = last;
+            }
+
+            if (end_of_line != first) {
+                size_t n = 0;
+
+                auto field = first;
+
+                while (true) {
+                    auto separator = static_cast<const char*>(std::memchr(field, ':', end_of_line - field));
+                    auto end_field = separator ? separator : end_of_line;
+
+                    // As with getline, there is no empty field at the end of the line
+                    if (!separator && end_field == field) {
+                        break;
+                    }
+
+                    if (n == parts.size()) {
+                        parts.emplace_back();
+                    }
+
+                    parts[n++].assign(field, end_field);
+
+                    if (!separator) {
+                        break;
+                    }
+
+                    field = separator + 1;
+                }
+
+                parts.resize(n);
+
+                f(parts);
+            }
+
+            first = end_of_line == last ? last : end_of_line + 1;
         }
     }
 
     template<typename Functor>
-    void parse_stream(std::istream& file, Functor f){
+    void parse_buffer(const char* first, const char* last, Functor f){
         next_id = 1;
 
-        std::string line;
-        while (file.good() && getline(file, line)) {
-            if (line.empty()) {
-                continue;
-            }
+        auto& entries = writable().entries;
 
-            auto parts = split(line, ':');
+        entries.reserve(entries.size() + std::count(first, last, '\n') + 1);
 
+        for_each_line(first, last, [this, &f, &entries](std::vector<std::string>& parts) {
             T entry;
 
             f(parts, entry);
@@ -61,22 +209,43 @@ struct data_handler {
                 next_id = entry.id + 1;
             }
 
-            data.push_back(std::move(entry));
-        }
+            entries.push_back(std::move(entry));
+        });
     }
 
     template<typename Functor>
     void load(Functor f){
         //Make sure to clear the data first, as load_data can be called
         //several times
-        data.clear();
+        writable().entries.clear();
+        writable().invalidate_indexes();
+        ++version;
+
+        reset_changes();
 
         if(is_server_mode()){
-            auto res = budget::api_get(std::string("/") + module + "/list/");
+            if (load_changes(f)) {
+                return;
+            }
+
+            std::string synced_version;
+
+            auto synced = load_synced_rows(module, [this, &f, &synced_version](const char* first, const char* last, const std::string& rows_version) {
+                parse_buffer(first, last, f);
+                synced_version = rows_version;
+            });
+
+            if (synced) {
+                save_cache(synced_version);
+            } else {
+                // Note: The rows are only parsed once the whole response
+                // has been received, the client of cpp-httplib in use has
+                // no content receiver to parse them incrementally
+                auto res = budget::api_get(std::string("/") + module + "/list/");
 
-            if(res.success){
-                std::stringstream ss(res.result);
-                parse_stream(ss, f);
+                if(res.success){
+                    parse_buffer(res.result.data(), res.result.data() + res.result.size(), f);
+                }
             }
         } else {
             auto file_path = path_to_budget_file(path);
@@ -84,25 +253,39 @@ struct data_handler {
             if (!file_exists(file_path)) {
                 next_id = 1;
             } else {
-                std::ifstream file(file_path);
+                mapped_file file(file_path);
 
-                if (file.is_open()) {
-                    if (file.good()) {
-                        // We do not use the next_id saved anymore
-                        // Simply consume it
-                        size_t fake;
-                        file >> fake;
-                        file.get();
+                // We do not use the next_id saved anymore
+                // Simply skip the first line
+                auto first = static_cast<const char*>(std::memchr(file.begin(), '\n', file.size()));
 
-                        parse_stream(file, f);
-                    }
-                }
+                parse_buffer(first ? first + 1 : file.end(), file.end(), f);
             }
         }
     }
 
     void load(){
-        load([](std::vector<std::string>& parts, T& entry){ parts >> entry; });
+        if (!load_snapshot(has_snapshot<T>())) {
+            // The data file is stamped before being read, so that a
+            // concurrent modification can only make the snapshot stale
+            file_stamp stamp;
+            bool stamped = use_snapshot() && get_file_stamp(path_to_budget_file(path), stamp);
+
+            load([](std::vector<std::string>& parts, T& entry){ parts >> entry; });
+
+            // Refresh the snapshot if it was missing or out of date
+            if (stamped) {
+                save_snapshot(has_snapshot<T>(), stamp);
+            }
+        }
+
+        // The modifications not yet compacted into the data file
+        if (!is_server_mode()) {
+            replay_journal();
+        }
+
+        // The clients will need to load all the entries again
+        reset_changes();
     }
 
     void force_save() {
@@ -115,13 +298,49 @@ struct data_handler {
 
         auto file_path = path_to_budget_file(path);
 
-        std::ofstream file(file_path);
+        // A symbolic link is written through, not replaced
+        auto real_path = resolve_path(file_path);
+        auto tmp_path  = real_path + ".tmp";
 
-        // We still save the file ID so that it's still compatible with older versions for now
-        file << next_id << std::endl;
+        // The data is written to a temporary file first so that the data
+        // file is never left partially written
+        {
+            std::ofstream file(tmp_path);
 
-        for (auto& entry : data) {
-            file << entry << std::endl;
+            // We still save the file ID so that it's still compatible with older versions for now
+            file << next_id << '\n';
+
+            for (auto& entry : store->entries) {
+                file << entry << '\n';
+            }
+
+            file.close();
+
+            if (!file) {
+                std::cerr << "budget: error: Impossible to save " << path << std::endl;
+                std::remove(tmp_path.c_str());
+                return;
+            }
+        }
+
+        // The stamp is kept by the rename
+        file_stamp stamp;
+        bool stamped = use_snapshot() && get_file_stamp(tmp_path, stamp);
+
+        if (!replace_file(tmp_path, real_path, get_durability() != durability::none)) {
+            std::cerr << "budget: error: Impossible to save " << path << std::endl;
+            return;
+        }
+
+        // The snapshot must be written after the data file
+        if (stamped) {
+            save_snapshot(has_snapshot<T>(), stamp);
+        }
+
+        // The journal is now part of the data file
+        if (journal_entries || file_exists(journal_path())) {
+            std::remove(journal_path().c_str());
+            journal_entries = 0;
         }
 
         changed = false;
@@ -143,6 +362,12 @@ struct data_handler {
     }
 
     bool edit(T& value){
+        cpp_assert(!pinned, "The pinned data cannot be modified");
+
+        // The id cannot be changed, only the indexes on the contents are invalidated
+        writable().invalidate_content_indexes();
+        ++version;
+
         if(is_server_mode()){
             auto params = value.get_params();
 
@@ -156,13 +381,18 @@ struct data_handler {
                 return true;
             }
         } else {
-            set_changed();
+            record_change(value.id);
+            mark_changed("edit", value);
 
             return true;
         }
     }
 
     size_t add(T&& entry) {
+        cpp_assert(!pinned, "The pinned data cannot be modified");
+
+        ++version;
+
         if (is_server_mode()) {
             auto params = entry.get_params();
 
@@ -175,23 +405,85 @@ struct data_handler {
             } else {
                 entry.id = budget::to_number<size_t>(res.result);
 
-                data.push_back(std::forward<T>(entry));
+                writable().push_back(std::forward<T>(entry));
             }
         } else {
             entry.id = next_id++;
 
-            data.push_back(std::forward<T>(entry));
+            auto& current_store = writable();
+
+            current_store.push_back(std::forward<T>(entry));
 
-            set_changed();
+            record_change(current_store.entries.back().id);
+            mark_changed("add", current_store.entries.back());
         }
 
         return entry.id;
     }
 
+    /*!
+     * \brief Adds several entries at once.
+     *
+     * The entries are all added with the same version and the journal is
+     * written only once. This cannot be used in server mode.
+     *
+     * \return the ids of the new entries
+     */
+    std::vector<size_t> add_all(std::vector<T>&& entries) {
+        cpp_assert(!pinned, "The pinned data cannot be modified");
+        cpp_assert(!is_server_mode(), "add_all() should never be called in server mode");
+
+        ++version;
+
+        std::vector<size_t> ids;
+        ids.reserve(entries.size());
+
+        std::stringstream records;
+
+        auto& current_store = writable();
+
+        for (auto& entry : entries) {
+            entry.id = next_id++;
+            ids.push_back(entry.id);
+
+            current_store.push_back(std::move(entry));
+
+            record_change(current_store.entries.back().id);
+
+            if (is_server_running()) {
+                if (ids.size() > 1) {
+                    records << '\n';
+                }
+
+                records << "add:" << current_store.entries.back();
+            }
+        }
+
+        if (ids.empty()) {
+            return ids;
+        }
+
+        if (is_server_running()) {
+            append_journal(records.str(), ids.size());
+        } else {
+            mark_changed();
+        }
+
+        return ids;
+    }
+
     void remove(size_t id) {
-        data.erase(std::remove_if(data.begin(), data.end(),
-                                  [id](const T& entry) { return entry.id == id; }),
-                   data.end());
+        cpp_assert(!pinned, "The pinned data cannot be modified");
+
+        bool removed = writable().erase(id);
+
+        // The server may still know the entry, but otherwise, there is
+        // nothing to save when nothing has been removed
+        if (!removed && !is_server_mode()) {
+            return;
+        }
+
+        ++version;
 
         if (is_server_mode()) {
             std::map<std::string, std::string> params;
@@ -203,49 +495,95 @@ struct data_handler {
             if (!res.success) {
                 std::cerr << "error: Failed to delete from " << get_module() << std::endl;
             }
+        } else if (is_server_running()) {
+            record_change(id);
+            append_journal("delete:" + budget::to_string(id));
         } else {
-            set_changed();
+            mark_changed();
         }
     }
 
     bool exists(size_t id) {
-        for (auto& entry : data) {
-            if (entry.id == id) {
-                return true;
-            }
-        }
-
-        return false;
+        return current().exists(id);
     }
 
     T& operator[](size_t id) {
-        for (auto& value : data) {
-            if (value.id == id) {
-                return value;
-            }
-        }
+        return current().get(id);
+    }
+
+    /*!
+     * \brief Returns the entries of the given month.
+     */
+    data_range<T> month_range(budget::year year, budget::month month) {
+        return month_range(year, month, year, month);
+    }
+
+    /*!
+     * \brief Returns the entries between the two given months (inclusive).
+     *
+     * The entries are sorted by month, in the order of the data inside
+     * each month.
+     */
+    data_range<T> month_range(budget::year from_year, budget::month from_month, budget::year to_year, budget::month to_month) {
+        return current().month_range(from_year, from_month, to_year, to_month);
+    }
 
-        cpp_unreachable("The data must exists");
+    /*!
+     * \brief Returns the total amount of the entries of the given account
+     * during the given month.
+     */
+    budget::money account_total(size_t account, budget::year year, budget::month month) {
+        return current().account_total(account, year, month);
+    }
+
+    /*!
+     * \brief Returns the total amount of the entries during the given month.
+     */
+    budget::money month_total(budget::year year, budget::month month) {
+        return current().month_total(year, month);
+    }
+
+    /*!
+     * \brief Returns the entries of the given asset, sorted by date.
+     */
+    data_range<T> asset_series(size_t asset_id) {
+        return current().asset_series(asset_id);
+    }
+
+    /*!
+     * \brief Returns the latest entry of the given asset, or nullptr if
+     * there are none.
+     */
+    T* last_asset_entry(size_t asset_id) {
+        return current().last_asset_entry(asset_id);
+    }
+
+    /*!
+     * \brief Returns the latest entry of the given asset at the given
+     * date, or nullptr if there are none.
+     */
+    T* last_asset_entry(size_t asset_id, budget::date d) {
+        return current().last_asset_entry(asset_id, d);
     }
 
     size_t size() const {
-        return data.size();
+        return current().entries.size();
     }
 
     decltype(auto) begin() {
-        return data.begin();
+        return current().entries.begin();
     }
 
     decltype(auto) begin() const {
-        return data.begin();
+        return current().entries.cbegin();
     }
 
     decltype(auto) end() {
-        return data.end();
+        return current().entries.end();
     }
 
     decltype(auto) end() const {
-        return data.end();
+        return current().entries.cend();
     }
 
     const char* get_module() const {
@@ -255,7 +593,481 @@ struct data_handler {
 private:
     const char* module;
     const char* path;
-    bool changed = false;
+    std::atomic<bool> changed{false}; // Also read by the flusher of the server
+
+    // Number of records in the journal since the last compaction
+    size_t journal_entries = 0;
+
+    // The current version of the entries, shared with the readers that
+    // have pinned it
+    std::shared_ptr<data_store<T>> store = std::make_shared<data_store<T>>();
+    std::atomic<size_t> version{0};
+
+    // The version pinned by the current thread, if any
+    static thread_local std::shared_ptr<data_store<T>> pinned;
+    static thread_local size_t pinned_version;
+
+    // The entries modified since the last load, so that the clients can
+    // only download the changes (server only)
+    std::mutex changes_mutex;
+    std::vector<std::pair<size_t, size_t>> changes; // (version, id), sorted by version
+    size_t changes_start = 0;                       // The changes are known after this version
+
+    static constexpr const size_t max_changes = 10000;
+
+    data_store<T>& current() {
+        return pinned ? *pinned : writable();
+    }
+
+    const data_store<T>& current() const {
+        return pinned ? *pinned : *store;
+    }
+
+    /*!
+     * \brief Returns the current version of the entries, to modify them.
+     *
+     * If some readers have still pinned this version, the entries are
+     * copied with their indexes first (copy-on-write). The entries must
+     * not be pinned concurrently.
+     */
+    data_store<T>& writable() {
+        if (store.use_count() > 1) {
+            store = std::make_shared<data_store<T>>(*store);
+        }
+
+        return *store;
+    }
+
+    /*!
+     * \brief Pin the current version of the entries for the calling thread.
+     *
+     * The entries are not copied, they are only copied by the next
+     * modification, if they are still pinned at this time. The entries
+     * must not be modified concurrently.
+     */
+    void pin() {
+        pinned         = store;
+        pinned_version = version;
+    }
+
+    void unpin() {
+        pinned.reset();
+    }
+
+    void record_change(size_t id) {
+        if (!is_server_running()) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(changes_mutex);
+
+        changes.emplace_back(version, id);
+
+        // Only the most recent changes are kept
+        if (changes.size() > max_changes) {
+            auto dropped = changes.size() - max_changes / 2;
+
+            changes_start = changes[dropped - 1].first;
+            changes.erase(changes.begin(), changes.begin() + dropped);
+        }
+    }
+
+    /*!
+     * \brief Forget the changes, after the entries have been modified
+     * without knowing which ones.
+     */
+    void reset_changes() {
+        std::lock_guard<std::mutex> lock(changes_mutex);
+
+        changes.clear();
+        changes_start = version;
+    }
+
+    void write_changes(std::ostream& out, size_t since) {
+        cpp_assert(pinned, "The data must be pinned to write the changes");
+
+        std::vector<size_t> ids;
+        bool full = true;
+
+        {
+            std::lock_guard<std::mutex> lock(changes_mutex);
+
+            // The changes made after the data was pinned are not visible
+            if (since && since >= changes_start && since <= pinned_version) {
+                full = false;
+
+                auto it = std::upper_bound(changes.begin(), changes.end(), since, [](size_t v, const std::pair<size_t, size_t>& change) {
+                    return v < change.first;
+                });
+
+                for (; it != changes.end() && it->first <= pinned_version; ++it) {
+                    ids.push_back(it->second);
+                }
+            }
+        }
+
+        out << pinned_version << ':' << (full ? "full" : "delta") << '\n';
+
+        if (full) {
+            for (auto& entry : pinned->entries) {
+                out << entry << '\n';
+            }
+
+            return;
+        }
+
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+        for (auto id : ids) {
+            if (pinned->exists(id)) {
+                out << pinned->get(id) << '\n';
+            } else {
+                out << '-' << id << '\n';
+            }
+        }
+    }
+
+    bool use_cache() const {
+        if (!is_server_mode() || config_contains("random")) {
+            return false;
+        }
+
+        return !(config_contains("server_cache") && config_value("server_cache") == "false");
+    }
+
+    std::string cache_path() const {
+        return path_to_budget_file(path) + ".cache";
+    }
+
+    /*!
+     * \brief Load the entries from the local cache and then the changes
+     * made on the server since the cache was saved (server mode only).
+     */
+    template<typename Functor>
+    bool load_changes(Functor f) {
+        if (!use_cache() || !file_exists(cache_path())) {
+            return false;
+        }
+
+        std::string cached_version; // epoch:version
+
+        {
+            mapped_file file(cache_path());
+
+            auto end_of_line = static_cast<const char*>(std::memchr(file.begin(), '\n', file.size()));
+
+            if (!end_of_line) {
+                return false;
+            }
+
+            cached_version.assign(file.begin(), end_of_line);
+
+            parse_buffer(end_of_line + 1, file.end(), f);
+        }
+
+        auto separator = cached_version.find(':');
+
+        if (separator == std::string::npos) {
+            writable().entries.clear();
+            writable().invalidate_indexes();
+
+            return false;
+        }
+
+        auto res = budget::api_get(std::string("/") + module + "/changes/?since=" + cached_version.substr(separator + 1)
+                                   + "&epoch=" + cached_version.substr(0, separator), true);
+
+        auto first = res.result.data();
+        auto last  = res.result.data() + res.result.size();
+
+        auto end_of_line = res.success ? static_cast<const char*>(std::memchr(first, '\n', last - first)) : nullptr;
+
+        // epoch:version:full or epoch:version:delta
+        std::string header(first, end_of_line ? end_of_line : first);
+
+        auto mode_separator = header.rfind(':');
+        auto mode           = mode_separator == std::string::npos ? "" : header.substr(mode_separator + 1);
+        auto rows_version   = header.substr(0, mode_separator);
+
+        // The server does not support it, everything is loaded again
+        if (mode != "full" && mode != "delta") {
+            writable().entries.clear();
+            writable().invalidate_indexes();
+
+            return false;
+        }
+
+        if (mode == "full") {
+            writable().entries.clear();
+            writable().invalidate_indexes();
+
+            parse_buffer(end_of_line + 1, last, f);
+        } else {
+            apply_changes(end_of_line + 1, last, f);
+        }
+
+        if (rows_version != cached_version) {
+            save_cache(rows_version);
+        }
+
+        return true;
+    }
+
+    template<typename Functor>
+    void apply_changes(const char* first, const char* last, Functor f) {
+        auto& current_store = writable();
+
+        for_each_line(first, last, [this, &f, &current_store](std::vector<std::string>& parts) {
+            auto& front = parts.front();
+
+            if (front[0] == '-') {
+                current_store.erase(budget::to_number<size_t>(front.data() + 1, front.data() + front.size()));
+                return;
+            }
+
+            T entry;
+            f(parts, entry);
+
+            if (current_store.exists(entry.id)) {
+                current_store.get(entry.id) = std::move(entry);
+                current_store.invalidate_content_indexes();
+            } else {
+                if (entry.id >= next_id) {
+                    next_id = entry.id + 1;
+                }
+
+                current_store.push_back(std::move(entry));
+            }
+        });
+    }
+
+    /*!
+     * \brief Save the entries in the local cache, with their version on the
+     * server (server mode only).
+     */
+    void save_cache(const std::string& rows_version) {
+        if (!use_cache() || rows_version.empty()) {
+            return;
+        }
+
+        auto real_path = resolve_path(cache_path());
+        auto tmp_path  = real_path + ".tmp";
+
+        {
+            std::ofstream file(tmp_path);
+
+            file << rows_version << '\n';
+
+            for (auto& entry : store->entries) {
+                file << entry << '\n';
+            }
+
+            file.close();
+
+            if (!file) {
+                std::remove(tmp_path.c_str());
+                return;
+            }
+        }
+
+        // The cache can always be downloaded again, no need to sync it
+        replace_file(tmp_path, real_path, false);
+    }
+
+    bool use_snapshot() const {
+        return !is_server_mode() && is_snapshot_enabled() && !config_contains("random");
+    }
+
+    bool load_snapshot(std::false_type /*has_snapshot*/) {
+        return false;
+    }
+
+    bool load_snapshot(std::true_type /*has_snapshot*/) {
+        auto file_path = path_to_budget_file(path);
+
+        if (!use_snapshot() || !is_snapshot_fresh(file_path)) {
+            return false;
+        }
+
+        snapshot_reader reader(snapshot_path(file_path));
+
+        if (!reader.is_valid()) {
+            return false;
+        }
+
+        auto& current_store = writable();
+
+        current_store.entries.clear();
+        current_store.entries.reserve(reader.size());
+        current_store.invalidate_indexes();
+        ++version;
+
+        next_id = 1;
+
+        for (size_t i = 0; i < reader.size(); ++i) {
+            T entry;
+
+            reader >> entry;
+            reader.next_row();
+
+            if (entry.id >= next_id) {
+                next_id = entry.id + 1;
+            }
+
+            current_store.entries.push_back(std::move(entry));
+        }
+
+        // In case of corrupted snapshot, fallback to the data file
+        if (!reader.is_valid()) {
+            current_store.entries.clear();
+            return false;
+        }
+
+        return true;
+    }
+
+    void save_snapshot(std::false_type /*has_snapshot*/, const file_stamp& /*stamp*/) {
+        // Nothing to save
+    }
+
+    void save_snapshot(std::true_type /*has_snapshot*/, const file_stamp& stamp) {
+        auto file_path = path_to_budget_file(path);
+
+        snapshot_writer writer;
+
+        for (auto& entry : store->entries) {
+            writer << entry;
+            writer.next_row();
+        }
+
+        if (!writer.write(snapshot_path(file_path), stamp)) {
+            std::cerr << "budget: error: Impossible to write the snapshot of " << path << std::endl;
+        }
+    }
+
+    void mark_changed() {
+        // When the server is running, it will be saved by the flusher
+        changed = true;
+    }
+
+    void mark_changed(const char* operation, const T& entry) {
+        if (is_server_running()) {
+            std::stringstream record;
+            record << operation << ':' << entry;
+            append_journal(record.str());
+        } else {
+            changed = true;
+        }
+    }
+
+    std::string journal_path() const {
+        return path_to_budget_file(path) + ".journal";
+    }
+
+    /*!
+     * \brief Append a record to the journal instead of rewriting the whole
+     * data file. The journal is compacted into the data file once it
+     * contains enough records.
+     *
+     * Several records can be appended at once, separated by new lines.
+     */
+    void append_journal(const std::string& record, size_t records = 1) {
+        if (budget::config_contains("random")) {
+            std::cerr << "budget: error: Saving is disabled in random mode" << std::endl;
+            return;
+        }
+
+        {
+            std::ofstream file(journal_path(), std::ios::app);
+            file << record << '\n';
+            file.flush();
+
+            if (file && get_durability() == durability::write && !sync_file(journal_path())) {
+                file.setstate(std::ios::failbit);
+            }
+
+            if (!file) {
+                // Do not loose the modification if the journal cannot be written
+                changed = true;
+                return;
+            }
+        }
+
+        // The compaction is done by the flusher
+        if ((journal_entries += records) >= journal_compaction_threshold()) {
+            changed = true;
+        }
+    }
+
+    /*!
+     * \brief Apply the records of the journal to the loaded data.
+     *
+     * Replaying is idempotent since the add and edit records contain the
+     * complete entries. A record without end of line has been interrupted
+     * and is ignored.
+     */
+    void replay_journal() {
+        auto file_path = journal_path();
+
+        if (!file_exists(file_path)) {
+            return;
+        }
+
+        mapped_file file(file_path);
+
+        auto first = file.begin();
+        auto last  = file.end();
+
+        // Ignore an incomplete last record
+        while (last != first && *(last - 1) != '\n') {
+            --last;
+        }
+
+        journal_entries = 0;
+
+        auto& current_store = writable();
+
+        for_each_line(first, last, [this, &current_store](std::vector<std::string>& parts) {
+            auto operation = parts.front();
+            parts.erase(parts.begin());
+
+            if (operation == "add" || operation == "edit") {
+                T entry;
+                parts >> entry;
+
+                if (current_store.exists(entry.id)) {
+                    current_store.get(entry.id) = std::move(entry);
+                } else {
+                    if (entry.id >= next_id) {
+                        next_id = entry.id + 1;
+                    }
+
+                    current_store.push_back(std::move(entry));
+                }
+            } else if (operation == "delete" && !parts.empty()) {
+                current_store.erase(budget::to_number<size_t>(parts.front()));
+            } else {
+                std::cerr << "budget: error: Invalid record in the journal of " << path << std::endl;
+            }
+
+            current_store.invalidate_content_indexes();
+            ++journal_entries;
+        });
+
+        ++version;
+
+        // The journal will be compacted by the next save
+        if (journal_entries) {
+            changed = true;
+        }
+    }
 };
 
+template<typename T>
+thread_local std::shared_ptr<data_store<T>> data_handler<T>::pinned;
+
+template<typename T>
+thread_local size_t data_handler<T>::pinned_version;
+
 } //end of namespace budget
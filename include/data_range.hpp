@@ -0,0 +1,78 @@
+//=======================================================================
+// Copyright (c) 2013-2018 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+namespace budget {
+
+/*!
+ * \brief A view over a subset of the entries of a data_handler.
+ *
+ * The range is made of indexes into the data of the handler. As for
+ * iterators over a std::vector, the range is invalidated by any
+ * modification of the data.
+ */
+template<typename T>
+struct data_range {
+    using index_iterator = std::vector<size_t>::const_iterator;
+
+    struct iterator {
+        std::vector<T>* data;
+        index_iterator it;
+
+        T& operator*() const {
+            return (*data)[*it];
+        }
+
+        T* operator->() const {
+            return &(*data)[*it];
+        }
+
+        iterator& operator++() {
+            ++it;
+            return *this;
+        }
+
+        bool operator==(const iterator& rhs) const {
+            return it == rhs.it;
+        }
+
+        bool operator!=(const iterator& rhs) const {
+            return it != rhs.it;
+        }
+    };
+
+    data_range(std::vector<T>& data, index_iterator first, index_iterator last) : data(&data), first(first), last(last) {
+        //Nothing else to init
+    }
+
+    iterator begin() const {
+        return {data, first};
+    }
+
+    iterator end() const {
+        return {data, last};
+    }
+
+    size_t size() const {
+        return last - first;
+    }
+
+    bool empty() const {
+        return first == last;
+    }
+
+private:
+    std::vector<T>* data;
+    index_iterator first;
+    index_iterator last;
+};
+
+} //end of namespace budget
@@ -0,0 +1,454 @@
+//=======================================================================
+// Copyright (c) 2013-2018 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <type_traits>
+
+#include "cpp_utils/assert.hpp"
+
+#include "date.hpp"
+#include "money.hpp"
+#include "data_range.hpp"
+
+namespace budget {
+
+/*!
+ * \brief Indicates if the entries of the given type are amounts of an
+ * account at a given date (expenses and earnings).
+ */
+template <typename T, typename Enable = void>
+struct is_account_entry : std::false_type {};
+
+template <typename T>
+struct is_account_entry<T, std::enable_if_t<
+    std::is_same<std::decay_t<decltype(std::declval<T&>().account)>, size_t>::value &&
+    std::is_same<std::decay_t<decltype(std::declval<T&>().amount)>, budget::money>::value &&
+    std::is_same<std::decay_t<decltype(std::declval<T&>().date)>, budget::date>::value>> : std::true_type {};
+
+/*!
+ * \brief Indicates if the entries of the given type are values of an
+ * asset at a given date (asset values).
+ */
+template <typename T, typename Enable = void>
+struct is_asset_entry : std::false_type {};
+
+template <typename T>
+struct is_asset_entry<T, std::enable_if_t<
+    std::is_same<std::decay_t<decltype(std::declval<T&>().asset_id)>, size_t>::value &&
+    std::is_same<std::decay_t<decltype(std::declval<T&>().set_date)>, budget::date>::value>> : std::true_type {};
+
+/*!
+ * \brief The entries of a module with their indexes.
+ *
+ * The indexes are built lazily and can be built by several concurrent
+ * readers. Any modification of the entries must be followed by the
+ * invalidation of the indexes.
+ */
+template<typename T>
+struct data_store {
+    std::vector<T> entries;
+
+    data_store() = default;
+
+    /*!
+     * \brief Copy the entries with their valid indexes.
+     *
+     * The indexes of the copied store can be built concurrently.
+     */
+    data_store(const data_store& rhs) : entries(rhs.entries) {
+        std::lock_guard<std::mutex> lock(rhs.index_mutex);
+
+        if (rhs.id_index_valid) {
+            id_index       = rhs.id_index;
+            id_index_valid = true;
+        }
+
+        if (rhs.month_index_valid) {
+            month_order       = rhs.month_order;
+            month_keys        = rhs.month_keys;
+            month_index_valid = true;
+        }
+
+        if (rhs.totals_valid) {
+            account_totals = rhs.account_totals;
+            month_totals   = rhs.month_totals;
+            totals_valid   = true;
+        }
+
+        if (rhs.series_index_valid) {
+            series             = rhs.series;
+            series_index_valid = true;
+        }
+    }
+
+    data_store& operator=(const data_store& rhs) = delete;
+
+    bool exists(size_t id) {
+        if (!id_index_valid) {
+            build_id_index();
+        }
+
+        return id_index.count(id);
+    }
+
+    T& get(size_t id) {
+        if (!id_index_valid) {
+            build_id_index();
+        }
+
+        auto it = id_index.find(id);
+
+        if (it == id_index.end()) {
+            cpp_unreachable("The data must exists");
+        }
+
+        return entries[it->second];
+    }
+
+    /*!
+     * \brief Returns the entries between the two given months (inclusive).
+     *
+     * The entries are sorted by month, in the order of the entries inside
+     * each month.
+     */
+    data_range<T> month_range(budget::year from_year, budget::month from_month, budget::year to_year, budget::month to_month) {
+        if (!month_index_valid) {
+            build_month_index();
+        }
+
+        auto first = std::lower_bound(month_keys.begin(), month_keys.end(), month_key(from_year, from_month));
+        auto last  = std::upper_bound(first, month_keys.end(), month_key(to_year, to_month));
+
+        return {entries, month_order.cbegin() + (first - month_keys.begin()), month_order.cbegin() + (last - month_keys.begin())};
+    }
+
+    /*!
+     * \brief Returns the total amount of the entries of the given account
+     * during the given month.
+     */
+    budget::money account_total(size_t account, budget::year year, budget::month month) {
+        if (!totals_valid) {
+            build_totals();
+        }
+
+        auto it = account_totals.find(account_key(account, month_key(year, month)));
+        return it == account_totals.end() ? budget::money() : it->second;
+    }
+
+    /*!
+     * \brief Returns the total amount of the entries of all the accounts
+     * during the given month.
+     */
+    budget::money month_total(budget::year year, budget::month month) {
+        if (!totals_valid) {
+            build_totals();
+        }
+
+        auto it = month_totals.find(month_key(year, month));
+        return it == month_totals.end() ? budget::money() : it->second;
+    }
+
+    /*!
+     * \brief Returns the entries of the given asset, sorted by date.
+     *
+     * The entries with the same date are in the order of the entries.
+     */
+    data_range<T> asset_series(size_t asset_id) {
+        if (!series_index_valid) {
+            build_series_index(is_asset_entry<T>());
+        }
+
+        auto it = series.find(asset_id);
+
+        if (it == series.end()) {
+            return {entries, no_series.cbegin(), no_series.cend()};
+        }
+
+        return {entries, it->second.cbegin(), it->second.cend()};
+    }
+
+    /*!
+     * \brief Returns the latest entry of the given asset, or nullptr if
+     * there are none.
+     */
+    T* last_asset_entry(size_t asset_id) {
+        if (!series_index_valid) {
+            build_series_index(is_asset_entry<T>());
+        }
+
+        auto it = series.find(asset_id);
+
+        if (it == series.end()) {
+            return nullptr;
+        }
+
+        return &entries[it->second.back()];
+    }
+
+    /*!
+     * \brief Returns the latest entry of the given asset at the given
+     * date, or nullptr if there are none.
+     */
+    T* last_asset_entry(size_t asset_id, budget::date d) {
+        if (!series_index_valid) {
+            build_series_index(is_asset_entry<T>());
+        }
+
+        auto it = series.find(asset_id);
+
+        if (it == series.end()) {
+            return nullptr;
+        }
+
+        auto& positions = it->second;
+
+        auto next = std::upper_bound(positions.begin(), positions.end(), d, [this](const budget::date& value, size_t position) {
+            return value < entries[position].set_date;
+        });
+
+        if (next == positions.begin()) {
+            return nullptr;
+        }
+
+        return &entries[*(next - 1)];
+    }
+
+    void push_back(T&& entry) {
+        entries.push_back(std::forward<T>(entry));
+
+        // The new entry can simply be appended to the index
+        if (id_index_valid) {
+            id_index[entries.back().id] = entries.size() - 1;
+        }
+
+        // The totals are maintained incrementally
+        if (totals_valid) {
+            update_totals(entries.back(), true, is_account_entry<T>());
+        }
+
+        if (series_index_valid) {
+            add_to_series(entries.size() - 1, is_asset_entry<T>());
+        }
+
+        if (month_index_valid) {
+            add_to_month_index(entries.size() - 1, is_account_entry<T>());
+        }
+    }
+
+    bool erase(size_t id) {
+        if (!exists(id)) {
+            return false;
+        }
+
+        auto position = id_index[id];
+
+        if (totals_valid) {
+            update_totals(entries[position], false, is_account_entry<T>());
+        }
+
+        entries.erase(entries.begin() + position);
+
+        // All the following entries have been moved
+        id_index_valid     = false;
+        month_index_valid  = false;
+        series_index_valid = false;
+
+        return true;
+    }
+
+    void invalidate_indexes() {
+        id_index_valid     = false;
+        month_index_valid  = false;
+        totals_valid       = false;
+        series_index_valid = false;
+    }
+
+    /*!
+     * \brief Invalidate the indexes depending on the contents of the
+     * entries, when an entry has been modified in place (its id cannot
+     * change).
+     */
+    void invalidate_content_indexes() {
+        month_index_valid  = false;
+        totals_valid       = false;
+        series_index_valid = false;
+    }
+
+private:
+    // Index of the entries by id
+    std::atomic<bool> id_index_valid{false};
+    std::unordered_map<size_t, size_t> id_index; // id -> position in entries
+
+    // Index of the entries by (year, month)
+    std::atomic<bool> month_index_valid{false};
+    std::vector<size_t> month_order; // Indexes into entries, sorted by month
+    std::vector<size_t> month_keys;  // The key of each entry of month_order
+
+    // Totals of the amounts by (account, year, month) and by (year, month)
+    std::atomic<bool> totals_valid{false};
+    std::unordered_map<size_t, budget::money> account_totals;
+    std::unordered_map<size_t, budget::money> month_totals;
+
+    // Entries of each asset, sorted by date
+    std::atomic<bool> series_index_valid{false};
+    std::unordered_map<size_t, std::vector<size_t>> series; // asset -> positions in entries
+    const std::vector<size_t> no_series;
+
+    mutable std::mutex index_mutex;
+
+    static size_t month_key(budget::year year, budget::month month) {
+        return year.value * 12 + (month.value - 1);
+    }
+
+    static size_t account_key(size_t account, size_t month_key) {
+        // The month keys are well below 2^20
+        return (account << 20) | month_key;
+    }
+
+    void update_totals(const T& entry, bool add, std::true_type /*is_account_entry*/) {
+        auto month = month_key(entry.date.year(), entry.date.month());
+
+        if (add) {
+            account_totals[account_key(entry.account, month)] += entry.amount;
+            month_totals[month] += entry.amount;
+        } else {
+            account_totals[account_key(entry.account, month)] -= entry.amount;
+            month_totals[month] -= entry.amount;
+        }
+    }
+
+    void update_totals(const T& /*entry*/, bool /*add*/, std::false_type /*is_account_entry*/) {
+        // No totals for these entries
+    }
+
+    void add_to_series(size_t position, std::true_type /*is_asset_entry*/) {
+        auto& positions = series[entries[position].asset_id];
+
+        // The entry is after all the entries with the same date
+        auto it = std::upper_bound(positions.begin(), positions.end(), entries[position].set_date, [this](const budget::date& d, size_t p) {
+            return d < entries[p].set_date;
+        });
+
+        positions.insert(it, position);
+    }
+
+    void add_to_series(size_t /*position*/, std::false_type /*is_asset_entry*/) {
+        // No series for these entries
+    }
+
+    void add_to_month_index(size_t position, std::true_type /*is_account_entry*/) {
+        auto& entry = entries[position];
+        auto key    = month_key(entry.date.year(), entry.date.month());
+
+        // The entry is after all the entries of the same month, in most
+        // cases, it is simply appended at the end
+        auto it = std::upper_bound(month_keys.begin(), month_keys.end(), key);
+
+        month_order.insert(month_order.begin() + (it - month_keys.begin()), position);
+        month_keys.insert(it, key);
+    }
+
+    void add_to_month_index(size_t /*position*/, std::false_type /*is_account_entry*/) {
+        // The month index is only used for the account entries
+        month_index_valid = false;
+    }
+
+    void build_series_index(std::true_type /*is_asset_entry*/) {
+        std::lock_guard<std::mutex> lock(index_mutex);
+
+        if (series_index_valid) {
+            return;
+        }
+
+        series.clear();
+
+        for (size_t i = 0; i < entries.size(); ++i) {
+            series[entries[i].asset_id].push_back(i);
+        }
+
+        for (auto& positions : series) {
+            std::stable_sort(positions.second.begin(), positions.second.end(), [this](size_t a, size_t b) {
+                return entries[a].set_date < entries[b].set_date;
+            });
+        }
+
+        series_index_valid = true;
+    }
+
+    void build_series_index(std::false_type /*is_asset_entry*/) {
+        series_index_valid = true;
+    }
+
+    void build_totals() {
+        std::lock_guard<std::mutex> lock(index_mutex);
+
+        if (totals_valid) {
+            return;
+        }
+
+        account_totals.clear();
+        month_totals.clear();
+
+        for (auto& entry : entries) {
+            update_totals(entry, true, is_account_entry<T>());
+        }
+
+        totals_valid = true;
+    }
+
+    void build_id_index() {
+        std::lock_guard<std::mutex> lock(index_mutex);
+
+        if (id_index_valid) {
+            return;
+        }
+
+        id_index.clear();
+        id_index.reserve(entries.size());
+
+        for (size_t i = 0; i < entries.size(); ++i) {
+            id_index[entries[i].id] = i;
+        }
+
+        id_index_valid = true;
+    }
+
+    void build_month_index() {
+        std::lock_guard<std::mutex> lock(index_mutex);
+
+        if (month_index_valid) {
+            return;
+        }
+
+        month_order.resize(entries.size());
+
+        for (size_t i = 0; i < entries.size(); ++i) {
+            month_order[i] = i;
+        }
+
+        std::stable_sort(month_order.begin(), month_order.end(), [this](size_t a, size_t b) {
+            return month_key(entries[a].date.year(), entries[a].date.month()) < month_key(entries[b].date.year(), entries[b].date.month());
+        });
+
+        month_keys.resize(entries.size());
+
+        for (size_t i = 0; i < month_order.size(); ++i) {
+            auto& entry   = entries[month_order[i]];
+            month_keys[i] = month_key(entry.date.year(), entry.date.month());
+        }
+
+        month_index_valid = true;
+    }
+};
+
+} //end of namespace budget
@@ -14,7 +14,9 @@
 #include "module_traits.hpp"
 #include "money.hpp"
 #include "date.hpp"
+#include "data_range.hpp"
 #include "writer_fwd.hpp"
+#include "snapshot_fwd.hpp"
 
 namespace budget {
 
@@ -44,12 +46,40 @@ struct earning {
 std::ostream& operator<<(std::ostream& stream, const earning& earning);
 void operator>>(const std::vector<std::string>& parts, earning& earning);
 
+snapshot_writer& operator<<(snapshot_writer& writer, const earning& earning);
+snapshot_reader& operator>>(snapshot_reader& reader, earning& earning);
+
 void load_earnings();
 void save_earnings();
 
 std::vector<earning>& all_earnings();
+data_range<earning> all_earnings_month(budget::year year, budget::month month);
+data_range<earning> all_earnings_between(budget::year sy, budget::month sm, budget::year ey, budget::month em);
+
+/*!
+ * \brief Returns the total of the earnings of the given account during the
+ * given month.
+ */
+budget::money earnings_total(size_t account, budget::year year, budget::month month);
+
+/*!
+ * \brief Returns the total of the earnings of all the accounts with the given
+ * name during the given month.
+ */
+budget::money earnings_total(const std::string& account_name, budget::year year, budget::month month);
+
+/*!
+ * \brief Returns the total of the earnings during the given month.
+ */
+budget::money earnings_total(budget::year year, budget::month month);
 void add_earning(earning&& earning);
 
+/*!
+ * \brief Adds all the given earnings at once and returns their ids.
+ */
+std::vector<size_t> add_earnings(std::vector<earning>&& earnings);
+bool edit_earning(earning& earning);
+
 void set_earnings_changed();
 void set_earnings_next_id(size_t next_id);
 
@@ -14,7 +14,9 @@
 #include "module_traits.hpp"
 #include "money.hpp"
 #include "date.hpp"
+#include "data_range.hpp"
 #include "writer_fwd.hpp"
+#include "snapshot_fwd.hpp"
 
 namespace budget {
 
@@ -46,11 +48,38 @@ struct expense {
 std::ostream& operator<<(std::ostream& stream, const expense& expense);
 void operator>>(const std::vector<std::string>& parts, expense& expense);
 
+snapshot_writer& operator<<(snapshot_writer& writer, const expense& expense);
+snapshot_reader& operator>>(snapshot_reader& reader, expense& expense);
+
 void load_expenses();
 void save_expenses();
 
 std::vector<expense>& all_expenses();
+data_range<expense> all_expenses_month(budget::year year, budget::month month);
+data_range<expense> all_expenses_between(budget::year sy, budget::month sm, budget::year ey, budget::month em);
+
+/*!
+ * \brief Returns the total of the expenses of the given account during the
+ * given month.
+ */
+budget::money expenses_total(size_t account, budget::year year, budget::month month);
+
+/*!
+ * \brief Returns the total of the expenses of all the accounts with the given
+ * name during the given month.
+ */
+budget::money expenses_total(const std::string& account_name, budget::year year, budget::month month);
+
+/*!
+ * \brief Returns the total of the expenses during the given month.
+ */
+budget::money expenses_total(budget::year year, budget::month month);
 void add_expense(expense&& expense);
+
+/*!
+ * \brief Adds all the given expenses at once and returns their ids.
+ */
+std::vector<size_t> add_expenses(std::vector<expense>&& expenses);
 bool edit_expense(expense& expense);
 
 void set_expenses_changed();
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <cmath>
 #include <string>
 #include <ostream>
 
@@ -226,12 +227,109 @@ struct money {
     }
 };
 
+/*!
+ * \brief The rounding of the result of the fixed-point operations on money.
+ */
+enum class rounding {
+    down,    ///< Toward zero, the cents are truncated
+    nearest, ///< To the nearest cent, the halves away from zero
+    even,    ///< To the nearest cent, the halves to the even cent
+    floor,   ///< Toward negative infinity
+    ceil     ///< Toward positive infinity
+};
+
+constexpr const long RATE_SCALE = 1000000000;
+
+/*!
+ * \brief A fixed-point factor (exchange rate, multiplier or fraction) with
+ * nine decimals.
+ *
+ * The operations between money and rates are done on integers, the
+ * result is only rounded once, to the cent, with the given rounding.
+ */
+struct fixed_rate {
+    long value;
+
+    fixed_rate() : value(0) {
+        //Nothing to init
+    }
+
+    explicit fixed_rate(double rate) : value(std::llround(rate * RATE_SCALE)) {
+        //Nothing to init
+    }
+
+    /*!
+     * \brief Returns the rate corresponding to the given percentage
+     * (40.00 gives 0.4).
+     */
+    static fixed_rate percent(money percentage);
+
+    /*!
+     * \brief Returns the rate numerator / denominator (0 if the denominator is 0).
+     */
+    static fixed_rate ratio(money numerator, money denominator, rounding mode = rounding::nearest);
+
+    /*!
+     * \brief Returns the rate numerator / denominator (0 if the denominator is 0).
+     */
+    static fixed_rate ratio(fixed_rate numerator, fixed_rate denominator, rounding mode = rounding::nearest);
+
+    bool operator==(const fixed_rate& rhs) const {
+        return value == rhs.value;
+    }
+
+    bool operator!=(const fixed_rate& rhs) const {
+        return value != rhs.value;
+    }
+
+    bool operator<(const fixed_rate& rhs) const {
+        return value < rhs.value;
+    }
+
+    bool operator>(const fixed_rate& rhs) const {
+        return value > rhs.value;
+    }
+
+    bool zero() const {
+        return value == 0;
+    }
+
+    explicit operator double() const {
+        return value / double(RATE_SCALE);
+    }
+};
+
+/*!
+ * \brief Returns amount * rate, rounded to the cent.
+ */
+money multiply(money amount, fixed_rate rate, rounding mode = rounding::nearest);
+
+/*!
+ * \brief Returns the given percentage of the amount (percentage is 40.00
+ * for 40%), rounded to the cent.
+ */
+money percentage(money amount, money percentage, rounding mode = rounding::nearest);
+
+/*!
+ * \brief Returns amount / divisor, rounded to the cent.
+ */
+money divide(money amount, long divisor, rounding mode = rounding::nearest);
+
 std::ostream& operator<<(std::ostream& stream, const money& amount);
 
 std::string to_flat_string(const money& amount);
 
 money parse_money(const std::string& money_string);
 
+/*!
+ * \brief Indicates if the given string is a valid amount of money, in the
+ * format of the data files: an optional sign, the dollars and optionally a
+ * dot followed by the two digits of the cents.
+ *
+ * parse_money is more lenient and ignores the invalid characters.
+ */
+bool is_valid_money(const std::string& money_string);
+
 money random_money(size_t min, size_t max);
 
 std::string random_name(size_t length);
@@ -0,0 +1,60 @@
+//=======================================================================
+// Copyright (c) 2013-2018 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace budget {
+
+/*!
+ * \brief Hash and equality of the names, ignoring their case.
+ */
+struct name_icompare {
+    bool operator()(const std::string& lhs, const std::string& rhs) const;
+    size_t operator()(const std::string& value) const;
+};
+
+/*!
+ * \brief Gives ids to names (account, asset or expense name).
+ *
+ * The names that only differ by their case have the same id. The ids are
+ * small and contiguous, starting at zero, so that they can be used to
+ * index flat arrays instead of maps of strings.
+ *
+ * A table is meant to be local to one computation, the ids are only
+ * valid within the table that gave them.
+ */
+struct name_table {
+    /*!
+     * \brief Returns the id of the given name, giving it a new id if
+     * it has not been seen yet.
+     */
+    size_t id(const std::string& name);
+
+    /*!
+     * \brief Returns the name of the given id, as it was first seen.
+     */
+    const std::string& name(size_t id) const {
+        return names[id];
+    }
+
+    /*!
+     * \brief Returns the number of names with an id.
+     */
+    size_t size() const {
+        return names.size();
+    }
+
+private:
+    std::unordered_map<std::string, size_t, name_icompare, name_icompare> ids;
+    std::vector<std::string> names;
+};
+
+} //end of namespace budget
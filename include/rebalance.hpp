@@ -0,0 +1,85 @@
+//=======================================================================
+// Copyright (c) 2013-2018 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "money.hpp"
+
+namespace budget {
+
+/*!
+ * \brief The assets of the portfolio, stored as dense arrays.
+ *
+ * Each asset of the portfolio with a value or a desired allocation has
+ * the same index in all the arrays.
+ */
+struct portfolio_allocation {
+    std::vector<size_t> ids;            // The id of each asset
+    std::vector<budget::money> amounts; // The latest value, in the currency of the asset
+    std::vector<budget::money> values;  // The latest value, in the default currency
+    std::vector<budget::fixed_rate> desired; // The desired part of the portfolio (between 0 and 1)
+
+    // The part of each class in each asset (between 0 and 1)
+    std::vector<budget::fixed_rate> int_stocks;
+    std::vector<budget::fixed_rate> dom_stocks;
+    std::vector<budget::fixed_rate> bonds;
+    std::vector<budget::fixed_rate> cash;
+
+    budget::money total; // The total value, in the default currency
+
+    size_t size() const {
+        return ids.size();
+    }
+
+    /*!
+     * \brief Returns the current allocation of each asset, in percent.
+     */
+    std::vector<double> allocation() const;
+
+    /*!
+     * \brief Returns the total value of each class (international stocks,
+     * domestic stocks, bonds and cash), in the default currency.
+     */
+    std::array<budget::money, 4> class_values() const;
+};
+
+/*!
+ * \brief A plan to bring the portfolio to its desired allocation.
+ */
+struct rebalance_plan {
+    std::vector<budget::money> targets; // The desired value of each asset
+    std::vector<budget::money> trades;  // The amount to buy (positive) or sell (negative) of each asset
+    budget::money effort;               // The total of the trades, in absolute value
+};
+
+/*!
+ * \brief Collects the current state of the portfolio.
+ */
+portfolio_allocation current_portfolio_allocation();
+
+/*!
+ * \brief Computes the trades that bring each asset exactly to its desired
+ * allocation, after adding the given new money (or withdrawing, if it is
+ * negative).
+ */
+rebalance_plan full_rebalance(const portfolio_allocation& portfolio, budget::money new_money = budget::money());
+
+/*!
+ * \brief Computes the smallest trades that invest the given new money (or
+ * withdraw it, if it is negative) as close as possible to the desired
+ * allocation.
+ *
+ * Only buys are made when investing and only sells when withdrawing. The
+ * money goes first to the assets that are the furthest from their
+ * desired value.
+ */
+rebalance_plan minimal_rebalance(const portfolio_allocation& portfolio, budget::money new_money);
+
+} //end of namespace budget
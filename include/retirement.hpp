@@ -7,12 +7,14 @@
 
 #pragma once
 
+#include <array>
 #include <vector>
 #include <string>
 
 #include "module_traits.hpp"
 #include "writer_fwd.hpp"
 #include "date.hpp"
+#include "money.hpp"
 
 namespace budget {
 
@@ -28,6 +30,48 @@ struct module_traits<retirement_module> {
 };
 
 float fi_ratio(budget::date d);
+
+/*!
+ * \brief Returns the FI ratio at the given date, with an already computed
+ * net worth at this date.
+ */
+float fi_ratio(budget::date d, budget::money nw);
+
 void retirement_status(budget::writer& w);
 
+/*!
+ * \brief The results of a Monte Carlo simulation of the retirement.
+ */
+struct retirement_simulation {
+    size_t simulations = 0; // The number of simulated sequences of returns
+    size_t years       = 0; // The number of simulated years
+
+    double success        = 0.0; // The probability that the net worth lasts all the years when retiring now
+    double fi_probability = 0.0; // The probability to reach FI during the years
+
+    std::array<double, 3> fi_years; // The 10th, 50th and 90th percentiles of the years to FI
+
+    std::vector<std::array<budget::money, 5>> bands; // The 10th, 25th, 50th, 75th and 90th percentiles of the net worth each year, when retiring now
+};
+
+constexpr const size_t max_retirement_simulations = 100000; ///< The maximum number of simulations
+constexpr const size_t max_retirement_years       = 100;    ///< The maximum number of simulated years
+
+/*!
+ * \brief Simulates the net worth over many random sequences of returns.
+ *
+ * The returns are drawn for each class of the assets, either from a
+ * normal distribution or from the historical returns of the file given
+ * by retirement_returns_file=path. The simulations are run on all the
+ * cores.
+ *
+ * \throw budget_exception if there are too many simulations or years
+ */
+retirement_simulation simulate_retirement(size_t simulations);
+
+/*!
+ * \brief Display the results of a Monte Carlo simulation of the retirement.
+ */
+void retirement_simulate(budget::writer& w, const retirement_simulation& simulation);
+
 } //end of namespace budget
@@ -9,6 +9,9 @@
 
 #include <vector>
 #include <string>
+#include <mutex>
+#include <shared_mutex>
+#include <functional>
 
 #include "module_traits.hpp"
 
@@ -28,4 +31,44 @@ struct module_traits<server_module> {
 void set_server_running();
 bool is_server_running();
 
+/*!
+ * \brief Returns the lock protecting the data of the server.
+ *
+ * The pages and the read-only APIs only hold it in shared mode while
+ * pinning the data (see pinned_data) while the modifications hold it in
+ * exclusive mode.
+ */
+std::shared_timed_mutex& server_data_lock();
+
+/*!
+ * \brief Run the given function on a pinned version of the data.
+ *
+ * The lock of the data is only held while pinning the data, the function
+ * runs without blocking the modifications.
+ */
+void run_read_only(const std::function<void()>& function);
+
+/*!
+ * \brief Wraps a handler of the server so that it can read the data in
+ * parallel to other readers.
+ */
+template<typename Handler>
+auto read_only(Handler handler){
+    return [handler](const auto& req, auto& res) {
+        run_read_only([&]() { handler(req, res); });
+    };
+}
+
+/*!
+ * \brief Wraps a handler of the server so that it has exclusive access to
+ * the data.
+ */
+template<typename Handler>
+auto read_write(Handler handler){
+    return [handler](const auto& req, auto& res) {
+        std::unique_lock<std::shared_timed_mutex> lock(server_data_lock());
+        handler(req, res);
+    };
+}
+
 } //end of namespace budget
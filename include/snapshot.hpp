@@ -0,0 +1,161 @@
+//=======================================================================
+// Copyright (c) 2013-2018 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <type_traits>
+#include <cstdint>
+
+#include "money.hpp"
+#include "date.hpp"
+#include "utils.hpp"
+
+namespace budget {
+
+/*!
+ * \brief Identifies a version of a data file by its size and its
+ * modification time (in nanoseconds).
+ */
+struct file_stamp {
+    uint64_t size  = 0;
+    uint64_t mtime = 0;
+};
+
+/*!
+ * \brief Get the stamp of the given file.
+ * \return false if the file cannot be accessed.
+ */
+bool get_file_stamp(const std::string& path, file_stamp& stamp);
+
+/*!
+ * \brief Writer of a binary snapshot of the entries of a module.
+ *
+ * The values of each entry are written one by one, always in the same
+ * order, and next_row() is called at the end of each entry. The
+ * snapshot is stored by columns: each value is a fixed-width integer
+ * and the strings are stored once in a table and referenced by their
+ * index.
+ */
+struct snapshot_writer {
+    snapshot_writer& operator<<(int64_t value);
+    snapshot_writer& operator<<(const std::string& value);
+    snapshot_writer& operator<<(const budget::date& value);
+    snapshot_writer& operator<<(const budget::money& value);
+
+    snapshot_writer& operator<<(size_t value) {
+        return *this << int64_t(value);
+    }
+
+    snapshot_writer& operator<<(bool value) {
+        return *this << int64_t(value);
+    }
+
+    void next_row();
+
+    /*!
+     * \brief Write the snapshot, made from the version of the data file
+     * with the given stamp.
+     */
+    bool write(const std::string& path, const file_stamp& stamp) const;
+
+private:
+    size_t rows   = 0;
+    size_t column = 0;
+
+    std::vector<std::vector<int64_t>> columns;
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, int64_t> string_ids;
+
+    void push(int64_t value);
+};
+
+/*!
+ * \brief Reader of a binary snapshot written by snapshot_writer.
+ *
+ * The values are read directly from the memory mapped snapshot, in the
+ * same order as they were written.
+ */
+struct snapshot_reader {
+    explicit snapshot_reader(const std::string& path);
+
+    bool is_valid() const {
+        return valid;
+    }
+
+    size_t size() const {
+        return rows;
+    }
+
+    snapshot_reader& operator>>(int64_t& value);
+    snapshot_reader& operator>>(std::string& value);
+    snapshot_reader& operator>>(budget::date& value);
+    snapshot_reader& operator>>(budget::money& value);
+
+    snapshot_reader& operator>>(size_t& value) {
+        int64_t v;
+        *this >> v;
+        value = v;
+        return *this;
+    }
+
+    snapshot_reader& operator>>(bool& value) {
+        int64_t v;
+        *this >> v;
+        value = v;
+        return *this;
+    }
+
+    void next_row();
+
+private:
+    mapped_file file;
+    bool valid = false;
+
+    size_t rows    = 0;
+    size_t row     = 0;
+    size_t column  = 0;
+
+    std::vector<const char*> columns;
+    std::vector<std::pair<const char*, uint32_t>> strings;
+
+    int64_t pop();
+};
+
+/*!
+ * \brief Indicates if binary snapshots are enabled (data_snapshots=true)
+ */
+bool is_snapshot_enabled();
+
+/*!
+ * \brief Returns the path to the snapshot of the given data file
+ */
+std::string snapshot_path(const std::string& file_path);
+
+/*!
+ * \brief Indicates if the snapshot of the given data file has been made
+ * from its current version, with exactly the same stamp.
+ */
+bool is_snapshot_fresh(const std::string& file_path);
+
+/*!
+ * \brief Indicates if entries of the given type can be stored in a snapshot.
+ *
+ * This is the case when operator<<(snapshot_writer&, const T&) and
+ * operator>>(snapshot_reader&, T&) are declared for the type.
+ */
+template <typename T, typename Enable = void>
+struct has_snapshot : std::false_type {};
+
+template <typename T>
+struct has_snapshot<T, decltype(void(std::declval<snapshot_writer&>() << std::declval<const T&>()),
+                                void(std::declval<snapshot_reader&>() >> std::declval<T&>()))> : std::true_type {};
+
+} //end of namespace budget
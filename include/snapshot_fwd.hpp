@@ -0,0 +1,15 @@
+//=======================================================================
+// Copyright (c) 2013-2018 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+namespace budget {
+
+struct snapshot_writer;
+struct snapshot_reader;
+
+} //end of namespace budget
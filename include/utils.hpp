@@ -15,15 +15,72 @@
 #include <cctype>
 #include <locale>
 #include <iomanip>
+#include <limits>
+#include <type_traits>
+
+#include "budget_exception.hpp"
 
 namespace budget {
 
+/*!
+ * \brief Convert a range of characters to an integer.
+ *
+ * This does not allocate any memory. As with a stream, leading
+ * whitespaces are skipped, the conversion stops at the first invalid
+ * character and zero is returned if there are no digits.
+ *
+ * \param first Pointer to the first character
+ * \param last Pointer past the last character
+ * \return The converted integer
+ * \throw budget_exception if the number does not fit in the type
+ */
+template <typename T>
+inline T to_number(const char* first, const char* last) {
+    static_assert(std::is_integral<T>::value, "to_number(first, last) only supports integers");
+
+    while (first != last && std::isspace(static_cast<unsigned char>(*first))) {
+        ++first;
+    }
+
+    bool negative = false;
+
+    if (first != last && (*first == '-' || *first == '+')) {
+        negative = *first == '-';
+        ++first;
+    }
+
+    auto start = first;
+
+    const unsigned long long limit = std::numeric_limits<T>::max();
+
+    unsigned long long result = 0;
+
+    for (; first != last && *first >= '0' && *first <= '9'; ++first) {
+        unsigned long long digit = *first - '0';
+
+        if (result > (limit - digit) / 10) {
+            auto end = first;
+
+            // Only the number is part of the message
+            while (end != last && *end >= '0' && *end <= '9') {
+                ++end;
+            }
+
+            throw budget_exception("The number is too big: " + std::string(start, end));
+        }
+
+        result = result * 10 + digit;
+    }
+
+    return negative ? static_cast<T>(-static_cast<T>(result)) : static_cast<T>(result);
+}
+
 /*!
  * \brief Convert a string to a number of an arbitrary type.
  * \param text The string to convert.
  * \return The converted text in the good type.
  */
-template <typename T>
+template <typename T, std::enable_if_t<!std::is_integral<T>::value || std::is_same<T, bool>::value, int> = 0>
 inline T to_number (const std::string& text) {
     std::stringstream ss(text);
     T result;
@@ -31,6 +88,16 @@ inline T to_number (const std::string& text) {
     return result;
 }
 
+/*!
+ * \brief Convert a string to an integer, without going through a stream.
+ * \param text The string to convert.
+ * \return The converted text in the good type.
+ */
+template <typename T, std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value, int> = 0>
+inline T to_number (const std::string& text) {
+    return to_number<T>(text.data(), text.data() + text.size());
+}
+
 template<typename T>
 inline std::string to_string(T value){
     return std::to_string(value);
@@ -61,6 +128,61 @@ unsigned short terminal_height();
 bool file_exists(const std::string& name);
 bool folder_exists(const std::string& name);
 
+/*!
+ * \brief Flush the contents of the given file (or folder) to the disk.
+ */
+bool sync_file(const std::string& path);
+
+/*!
+ * \brief Returns the real path of the given file, with the symbolic links
+ * resolved, or the path itself if it cannot be resolved.
+ */
+std::string resolve_path(const std::string& path);
+
+/*!
+ * \brief Atomically replace the file at path with the file at tmp_path.
+ *
+ * The new file keeps the owner and the permissions of the replaced file.
+ * The path should not be a symbolic link, since the link itself would be
+ * replaced (see resolve_path).
+ *
+ * When sync is true, the new file is flushed to the disk before being
+ * renamed and the rename itself is flushed to the disk.
+ */
+bool replace_file(const std::string& tmp_path, const std::string& path, bool sync);
+
+/*!
+ * \brief A read-only view of the contents of a file.
+ *
+ * The file is mapped in memory when possible, otherwise its contents
+ * are read in a buffer.
+ */
+struct mapped_file {
+    explicit mapped_file(const std::string& path);
+    ~mapped_file();
+
+    mapped_file(const mapped_file& rhs) = delete;
+    mapped_file& operator=(const mapped_file& rhs) = delete;
+
+    const char* begin() const {
+        return first;
+    }
+
+    const char* end() const {
+        return first + length;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+private:
+    const char* first = nullptr;
+    size_t length     = 0;
+    bool mapped       = false;
+    std::string buffer;
+};
+
 std::vector<std::string> split(const std::string &s, char delim);
 std::vector<std::string> &split(const std::string &s, char delim, std::vector<std::string> &elems);
 
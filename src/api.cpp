@@ -8,10 +8,13 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <mutex>
+#include <utility>
 
 #include "cpp_utils/assert.hpp"
 
 #include "api.hpp"
+#include "compress.hpp"
 #include "config.hpp"
 #include "utils.hpp"
 #include "http.hpp"
@@ -32,6 +35,7 @@ budget::api_response base_api_get(Cli& cli, const std::string& api, bool silent)
 
     req.set_header("Host", (server + ":" + server_port).c_str());
     req.set_header("Accept", "*/*");
+    req.set_header("Accept-Encoding", "gzip");
     req.set_header("User-Agent", "cpp-httplib/0.1");
 
     if (budget::is_secure()) {
@@ -67,8 +71,22 @@ budget::api_response base_api_get(Cli& cli, const std::string& api, bool silent)
         }
 
         return {false, ""};
+    } else if (res->get_header_value("Content-Encoding") == "gzip") {
+        std::string body;
+
+        if (!budget::gzip_decompress(res->body, body)) {
+            if (!silent) {
+                std::cerr << "Request to the API failed!" << std::endl;
+                std::cerr << "  API: " << server << ":" << server_port << "/" << api_complete << std::endl;
+                std::cerr << "  Invalid compressed content" << std::endl;
+            }
+
+            return {false, ""};
+        }
+
+        return {true, std::move(body)};
     } else {
-        return {true, res->body};
+        return {true, std::move(res->body)};
     }
 }
 
@@ -136,42 +154,43 @@ budget::api_response base_api_post(Cli& cli, const std::string& api, const std::
 
         return {false, ""};
     } else {
-        return {true, res->body};
+        return {true, std::move(res->body)};
     }
 }
 
+// The client is shared by all the API calls of the process. The version
+// of cpp-httplib in use still opens a connection for each request, but the
+// client and its SSL context (settings and certificates) are only created
+// once.
+httplib::Client& api_client(){
+    static std::once_flag flag;
+    static httplib::Client* client = nullptr;
+
+    std::call_once(flag, [](){
+        auto server      = budget::config_value("server_url");
+        auto server_port = budget::config_value("server_port");
+
+        // The client is never destroyed, it is used until the end of the process
+        if (budget::is_server_ssl()) {
+            client = new httplib::SSLClient(server.c_str(), budget::to_number<size_t>(server_port));
+        } else {
+            client = new httplib::Client(server.c_str(), budget::to_number<size_t>(server_port));
+        }
+    });
+
+    return *client;
+}
+
 } // end of anonymous namespace
 
 budget::api_response budget::api_get(const std::string& api, bool silent) {
     cpp_assert(is_server_mode(), "api_get() should only be called in server mode");
 
-    auto server      = config_value("server_url");
-    auto server_port = config_value("server_port");
-
-    if(is_server_ssl()){
-        httplib::SSLClient cli(server.c_str(), budget::to_number<size_t>(server_port));
-
-        return base_api_get(cli, api, silent);
-    } else {
-        httplib::Client cli(server.c_str(), budget::to_number<size_t>(server_port));
-
-        return base_api_get(cli, api, silent);
-    }
+    return base_api_get(api_client(), api, silent);
 }
 
 budget::api_response budget::api_post(const std::string& api, const std::map<std::string, std::string>& params) {
     cpp_assert(is_server_mode(), "api_post() should only be called in server mode");
 
-    auto server      = config_value("server_url");
-    auto server_port = config_value("server_port");
-
-    if(is_server_ssl()){
-        httplib::SSLClient cli(server.c_str(), budget::to_number<size_t>(server_port));
-
-        return base_api_post(cli, api, params);
-    } else {
-        httplib::Client cli(server.c_str(), budget::to_number<size_t>(server_port));
-
-        return base_api_post(cli, api, params);
-    }
+    return base_api_post(api_client(), api, params);
 }
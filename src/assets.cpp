@@ -23,6 +23,7 @@
 #include "expenses.hpp"
 #include "writer.hpp"
 #include "currency.hpp"
+#include "rebalance.hpp"
 
 #include <curl/curl.h>
 
@@ -45,6 +46,21 @@ std::vector<std::string> get_asset_names(){
     return asset_names;
 }
 
+// The pairs to convert the currencies of the assets to the default currency
+std::vector<std::pair<std::string, std::string>> asset_currency_pairs(){
+    auto currency = get_default_currency();
+
+    std::vector<std::pair<std::string, std::string>> pairs;
+
+    for (auto& asset : all_assets()) {
+        if (asset.name != "DESIRED") {
+            pairs.emplace_back(asset.currency, currency);
+        }
+    }
+
+    return pairs;
+}
+
 } //end of anonymous namespace
 
 std::map<std::string, std::string> budget::asset::get_params(){
@@ -95,7 +111,11 @@ void budget::assets_module::handle(const std::vector<std::string>& args){
         if(subcommand == "show"){
             show_assets(w);
         } else if (subcommand == "rebalance") {
-            show_asset_rebalance(w);
+            if (args.size() > 2) {
+                show_asset_rebalance(w, parse_money(args[2]));
+            } else {
+                show_asset_rebalance(w);
+            }
         } else if (subcommand == "portfolio") {
             budget::show_asset_portfolio(w);
         } else if(subcommand == "add"){
@@ -168,7 +188,7 @@ void budget::assets_module::handle(const std::vector<std::string>& args){
                 throw budget_exception("Cannot delete special asset " + args[2]);
             }
 
-            for(auto& value : asset_values.data){
+            for(auto& value : asset_values.data()){
                 if(value.asset_id == id){
                     throw budget_exception("There are still asset values linked to asset " + args[2]);
                 }
@@ -349,7 +369,7 @@ budget::asset& budget::get_asset(size_t id){
 }
 
 budget::asset& budget::get_asset(std::string name){
-    for(auto& asset : assets.data){
+    for(auto& asset : assets.data()){
         if(asset.name == name){
             return asset;
         }
@@ -359,7 +379,7 @@ budget::asset& budget::get_asset(std::string name){
 }
 
 budget::asset& budget::get_desired_allocation(){
-    for(auto& asset : assets.data){
+    for(auto& asset : assets.data()){
         if(asset.name == "DESIRED" && asset.currency == "DESIRED"){
             return asset;
         }
@@ -443,8 +463,16 @@ void budget::operator>>(const std::vector<std::string>& parts, asset_value& asse
     }
 }
 
+snapshot_writer& budget::operator<<(snapshot_writer& writer, const asset_value& asset_value){
+    return writer << asset_value.id << asset_value.guid << asset_value.asset_id << asset_value.amount << asset_value.set_date;
+}
+
+snapshot_reader& budget::operator>>(snapshot_reader& reader, asset_value& asset_value){
+    return reader >> asset_value.id >> asset_value.guid >> asset_value.asset_id >> asset_value.amount >> asset_value.set_date;
+}
+
 bool budget::asset_exists(const std::string& name){
-    for (auto& asset : assets.data) {
+    for (auto& asset : assets.data()) {
         if (asset.name == name) {
             return true;
         }
@@ -454,22 +482,42 @@ bool budget::asset_exists(const std::string& name){
 }
 
 std::vector<asset>& budget::all_assets(){
-    return assets.data;
+    return assets.data();
 }
 
 std::vector<asset_value>& budget::all_asset_values(){
-    return asset_values.data;
+    return asset_values.data();
 }
 
 std::vector<asset_value> budget::all_sorted_asset_values() {
     auto sorted_asset_values = all_asset_values();
 
-    std::sort(sorted_asset_values.begin(), sorted_asset_values.end(),
+    std::stable_sort(sorted_asset_values.begin(), sorted_asset_values.end(),
               [](const budget::asset_value& a, const budget::asset_value& b) { return a.set_date < b.set_date; });
 
     return sorted_asset_values;
 }
 
+budget::data_range<asset_value> budget::sorted_asset_values(size_t asset_id){
+    return asset_values.asset_series(asset_id);
+}
+
+std::pair<bool, size_t> budget::find_last_asset_value(size_t asset_id){
+    if (auto* asset_value = asset_values.last_asset_entry(asset_id)) {
+        return std::make_pair(true, asset_value->id);
+    }
+
+    return std::make_pair(false, size_t(0));
+}
+
+std::pair<bool, size_t> budget::find_last_asset_value(size_t asset_id, budget::date d){
+    if (auto* asset_value = asset_values.last_asset_entry(asset_id, d)) {
+        return std::make_pair(true, asset_value->id);
+    }
+
+    return std::make_pair(false, size_t(0));
+}
+
 void budget::set_assets_changed(){
     assets.set_changed();
 }
@@ -494,6 +542,45 @@ std::string budget::get_default_currency(){
     return "CHF";
 }
 
+void budget::prefetch_asset_exchange_rates(){
+    prefetch_exchange_rates(asset_currency_pairs());
+}
+
+void budget::fetch_asset_exchange_rates(){
+    auto currency = get_default_currency();
+
+    std::vector<std::pair<std::string, std::string>> pairs;
+
+    // The first value in each currency
+    std::map<std::string, budget::date> first_values;
+
+    run_read_only([&pairs, &first_values]() {
+        pairs = asset_currency_pairs();
+
+        for (auto& asset_value : all_asset_values()) {
+            auto& asset = get_asset(asset_value.asset_id);
+
+            if (asset.name == "DESIRED") {
+                continue;
+            }
+
+            auto it = first_values.find(asset.currency);
+
+            if (it == first_values.end()) {
+                first_values.emplace(asset.currency, asset_value.set_date);
+            } else if (asset_value.set_date < it->second) {
+                it->second = asset_value.set_date;
+            }
+        }
+    });
+
+    prefetch_exchange_rates(pairs);
+
+    for (auto& first_value : first_values) {
+        fetch_exchange_rate_history(first_value.first, currency, first_value.second);
+    }
+}
+
 std::string to_percent(double p){
     std::stringstream ss;
 
@@ -502,7 +589,7 @@ std::string to_percent(double p){
     return ss.str();
 }
 void budget::show_assets(budget::writer& w){
-    if (!assets.data.size()) {
+    if (!assets.data().size()) {
         w << "No assets" << end_of_line;
         return;
     }
@@ -514,7 +601,7 @@ void budget::show_assets(budget::writer& w){
 
     // Display the assets
 
-    for(auto& asset : assets.data){
+    for(auto& asset : assets.data()){
         if(asset.name == "DESIRED" && asset.currency == "DESIRED"){
             continue;
         }
@@ -529,69 +616,26 @@ void budget::show_assets(budget::writer& w){
 
 
 void budget::show_asset_portfolio(budget::writer& w){
-    if (!asset_values.data.size()) {
+    if (!asset_values.data().size()) {
         w << "No asset values" << end_of_line;
         return;
     }
 
+    prefetch_asset_exchange_rates();
+
     w << title_begin << "Portfolio" << title_end;
 
     std::vector<std::string> columns = {"Name", "Total", "Currency", "Converted", "Allocation"};
     std::vector<std::vector<std::string>> contents;
 
-    budget::money total;
-
-    for(auto& asset : assets.data){
-        auto id = asset.id;
-
-        if (asset.portfolio) {
-            size_t asset_value_id  = 0;
-            bool asset_value_found = false;
-
-            for (auto& asset_value : asset_values.data) {
-                if (asset_value.asset_id == id) {
-                    if (!asset_value_found) {
-                        asset_value_found = true;
-                        asset_value_id    = asset_value.id;
-                    } else if (asset_value.set_date >= get_asset_value(asset_value_id).set_date) {
-                        asset_value_id = asset_value.id;
-                    }
-                }
-            }
-
-            if (asset_value_found) {
-                auto& asset_value = get_asset_value(asset_value_id);
-
-                auto conv_amount = asset_value.amount * exchange_rate(asset.currency, get_default_currency());
-
-                total += conv_amount;
-            }
-        }
-    }
-
-    for(auto& asset : assets.data){
-        auto id = asset.id;
+    auto total = get_portfolio_value();
 
+    for(auto& asset : assets.data()){
         if (asset.portfolio) {
-            size_t asset_value_id  = 0;
-            bool asset_value_found = false;
-
-            for (auto& asset_value : asset_values.data) {
-                if (asset_value.asset_id == id) {
-                    if (!asset_value_found) {
-                        asset_value_found = true;
-                        asset_value_id    = asset_value.id;
-                    } else if (asset_value.set_date >= get_asset_value(asset_value_id).set_date) {
-                        asset_value_id = asset_value.id;
-                    }
-                }
-            }
-
-            if (asset_value_found) {
-                auto& asset_value = get_asset_value(asset_value_id);
-                auto amount       = asset_value.amount;
-                auto conv_amount  = asset_value.amount * exchange_rate(asset.currency, get_default_currency());
-                auto allocation   = 100.0 * (conv_amount / total);
+            if (auto* asset_value = asset_values.last_asset_entry(asset.id)) {
+                auto amount      = asset_value->amount;
+                auto conv_amount = convert(amount, asset.currency);
+                auto allocation  = 100.0 * (conv_amount / total);
 
                 if (amount) {
                     contents.push_back({
@@ -612,109 +656,67 @@ void budget::show_asset_portfolio(budget::writer& w){
     w.display_table(columns, contents, 1, {}, 1, 2);
 }
 
-void budget::show_asset_rebalance(budget::writer& w){
-    if (!asset_values.data.size()) {
+void budget::show_asset_rebalance(budget::writer& w, budget::money new_money){
+    if (!asset_values.data().size()) {
         w << "No asset values" << end_of_line;
         return;
     }
 
+    prefetch_asset_exchange_rates();
+
     w << title_begin << "Rebalancing" << title_end;
 
     std::vector<std::string> columns = {"Name", "Total", "Currency", "Converted", "Allocation", "Desired Allocation", "Desired Total", "Difference"};
     std::vector<std::vector<std::string>> contents;
 
-    budget::money total;
+    auto portfolio  = current_portfolio_allocation();
+    auto allocation = portfolio.allocation();
+    auto plan       = full_rebalance(portfolio, new_money);
 
-    for(auto& asset : assets.data){
-        auto id = asset.id;
+    // With new money, also display the smallest trades to invest it
+    bool contribution = !new_money.zero();
 
-        if (asset.portfolio) {
-            size_t asset_value_id  = 0;
-            bool asset_value_found = false;
-
-            for (auto& asset_value : asset_values.data) {
-                if (asset_value.asset_id == id) {
-                    if (!asset_value_found) {
-                        asset_value_found = true;
-                        asset_value_id    = asset_value.id;
-                    } else if (asset_value.set_date >= get_asset_value(asset_value_id).set_date) {
-                        asset_value_id = asset_value.id;
-                    }
-                }
-            }
-
-            if (asset_value_found) {
-                auto& asset_value = get_asset_value(asset_value_id);
+    rebalance_plan minimal;
 
-                auto conv_amount = asset_value.amount * exchange_rate(asset.currency, get_default_currency());
-
-                total += conv_amount;
-            }
-        }
+    if (contribution) {
+        minimal = minimal_rebalance(portfolio, new_money);
+        columns.push_back("Minimal Trade");
     }
 
-    budget::money total_rebalance;
-
-    for(auto& asset : assets.data){
-        auto id = asset.id;
-
-        if (asset.portfolio) {
-            size_t asset_value_id  = 0;
-            bool asset_value_found = false;
-
-            for (auto& asset_value : asset_values.data) {
-                if (asset_value.asset_id == id) {
-                    if (!asset_value_found) {
-                        asset_value_found = true;
-                        asset_value_id    = asset_value.id;
-                    } else if (asset_value.set_date >= get_asset_value(asset_value_id).set_date) {
-                        asset_value_id = asset_value.id;
-                    }
-                }
-            }
-
-            budget::money amount;
-
-            if (asset_value_found) {
-                auto& asset_value = get_asset_value(asset_value_id);
-                amount       = asset_value.amount;
-            }
-
-            if(amount.zero() && asset.portfolio_alloc.zero()){
-                continue;
-            }
-
-            auto conv_amount = amount * exchange_rate(asset.currency, get_default_currency());
-            auto allocation  = 100.0 * (conv_amount / total);
-            auto desired     = total * (float(asset.portfolio_alloc) / 100.0);
-            auto difference  = desired - conv_amount;
-
-            total_rebalance += difference.abs();
-
-            if (amount || difference) {
-                contents.push_back({
-                    asset.name,
-                    to_string(amount),
-                    asset.currency,
-                    to_string(conv_amount),
-                    to_percent(allocation),
-                    to_string(asset.portfolio_alloc),
-                    to_string(desired),
-                    format_money(difference)
-                });
+    for (size_t i = 0; i < portfolio.size(); ++i) {
+        if (portfolio.amounts[i] || plan.trades[i]) {
+            auto& asset = get_asset(portfolio.ids[i]);
+
+            contents.push_back({
+                asset.name,
+                to_string(portfolio.amounts[i]),
+                asset.currency,
+                to_string(portfolio.values[i]),
+                to_percent(allocation[i]),
+                to_string(asset.portfolio_alloc),
+                to_string(plan.targets[i]),
+                format_money(plan.trades[i])
+            });
+
+            if (contribution) {
+                contents.back().push_back(format_money(minimal.trades[i]));
             }
         }
     }
 
     // Display the total rebalancing effort
-    contents.push_back({"", "", "", "", "", "", "", ""});
-    contents.push_back({"Total effort", "", "", "", "", "", "", format_money(total_rebalance)});
+    contents.emplace_back(columns.size(), "");
+    contents.push_back({"Total effort", "", "", "", "", "", "", format_money(plan.effort)});
+
+    if (contribution) {
+        contents.back().push_back(format_money(minimal.effort));
+    }
 
     w.display_table(columns, contents, 1, {}, 1, 2);
 }
 
 void budget::small_show_asset_values(budget::writer& w){
-    if (!asset_values.data.size()) {
+    if (!asset_values.data().size()) {
         w << "No asset values" << end_of_line;
         return;
     }
@@ -730,33 +732,16 @@ void budget::small_show_asset_values(budget::writer& w){
     budget::money cash;
     budget::money total;
 
-    for(auto& asset : assets.data){
-        auto id = asset.id;
-
-        size_t asset_value_id = 0;
-        bool asset_value_found = false;
-
-        for (auto& asset_value : asset_values.data) {
-            if (asset_value.asset_id == id) {
-                if(!asset_value_found){
-                    asset_value_found = true;
-                    asset_value_id    = asset_value.id;
-                } else if(asset_value.set_date >= get_asset_value(asset_value_id).set_date){
-                    asset_value_id    = asset_value.id;
-                }
-            }
-        }
-
-        if(asset_value_found){
-            auto& asset_value = get_asset_value(asset_value_id);
-            auto amount       = asset_value.amount;
+    for(auto& asset : assets.data()){
+        if (auto* asset_value = asset_values.last_asset_entry(asset.id)) {
+            auto amount = asset_value->amount;
 
             if (amount) {
                 contents.push_back({asset.name,
                                     to_string(amount),
                                     asset.currency});
 
-                total += amount * exchange_rate(asset.currency, get_default_currency());
+                total += convert(amount, asset.currency);
             }
         }
     }
@@ -770,7 +755,7 @@ void budget::small_show_asset_values(budget::writer& w){
 }
 
 void budget::show_asset_values(budget::writer& w){
-    if (!asset_values.data.size()) {
+    if (!asset_values.data().size()) {
         w << "No asset values" << end_of_line;
         return;
     }
@@ -786,46 +771,29 @@ void budget::show_asset_values(budget::writer& w){
     budget::money cash;
     budget::money total;
 
-    for(auto& asset : assets.data){
-        auto id = asset.id;
-
-        size_t asset_value_id = 0;
-        bool asset_value_found = false;
-
-        for (auto& asset_value : asset_values.data) {
-            if (asset_value.asset_id == id) {
-                if(!asset_value_found){
-                    asset_value_found = true;
-                    asset_value_id    = asset_value.id;
-                } else if(asset_value.set_date >= get_asset_value(asset_value_id).set_date){
-                    asset_value_id    = asset_value.id;
-                }
-            }
-        }
-
-        if(asset_value_found){
-            auto& asset_value = get_asset_value(asset_value_id);
-            auto amount       = asset_value.amount;
+    for(auto& asset : assets.data()){
+        if (auto* asset_value = asset_values.last_asset_entry(asset.id)) {
+            auto amount = asset_value->amount;
 
             if (amount) {
                 contents.push_back({asset.name,
-                                    to_string(amount * (float(asset.int_stocks) / 100.0)),
-                                    to_string(amount * (float(asset.dom_stocks) / 100.0)),
-                                    to_string(amount * (float(asset.bonds) / 100.0)),
-                                    to_string(amount * (float(asset.cash) / 100.0)),
+                                    to_string(percentage(amount, asset.int_stocks)),
+                                    to_string(percentage(amount, asset.dom_stocks)),
+                                    to_string(percentage(amount, asset.bonds)),
+                                    to_string(percentage(amount, asset.cash)),
                                     to_string(amount),
                                     asset.currency});
 
-                auto int_stocks_amount = amount * (float(asset.int_stocks) / 100.0);
-                auto dom_stocks_amount = amount * (float(asset.dom_stocks) / 100.0);
-                auto bonds_amount      = amount * (float(asset.bonds) / 100.0);
-                auto cash_amount       = amount * (float(asset.cash) / 100.0);
+                auto int_stocks_amount = percentage(amount, asset.int_stocks);
+                auto dom_stocks_amount = percentage(amount, asset.dom_stocks);
+                auto bonds_amount      = percentage(amount, asset.bonds);
+                auto cash_amount       = percentage(amount, asset.cash);
 
-                int_stocks += int_stocks_amount * exchange_rate(asset.currency, get_default_currency());
-                dom_stocks += dom_stocks_amount * exchange_rate(asset.currency, get_default_currency());
-                bonds += bonds_amount * exchange_rate(asset.currency, get_default_currency());
-                cash += cash_amount * exchange_rate(asset.currency, get_default_currency());
-                total += amount * exchange_rate(asset.currency, get_default_currency());
+                int_stocks += convert(int_stocks_amount, asset.currency);
+                dom_stocks += convert(dom_stocks_amount, asset.currency);
+                bonds += convert(bonds_amount, asset.currency);
+                cash += convert(cash_amount, asset.currency);
+                total += convert(amount, asset.currency);
             }
         }
     }
@@ -872,18 +840,18 @@ void budget::show_asset_values(budget::writer& w){
                             ""});
 
         contents.push_back({"Desired Total",
-                            to_string(total * (float(desired.int_stocks) / 100.0)),
-                            to_string(total * (float(desired.dom_stocks) / 100.0)),
-                            to_string(total * (float(desired.bonds) / 100.0)),
-                            to_string(total * (float(desired.cash) / 100.0)),
+                            to_string(percentage(total, desired.int_stocks)),
+                            to_string(percentage(total, desired.dom_stocks)),
+                            to_string(percentage(total, desired.bonds)),
+                            to_string(percentage(total, desired.cash)),
                             to_string(total),
                             get_default_currency()});
 
         contents.push_back({"Difference (need)",
-                            to_string(total * (float(desired.int_stocks) / 100.0) - int_stocks),
-                            to_string(total * (float(desired.dom_stocks) / 100.0) - dom_stocks),
-                            to_string(total * (float(desired.bonds) / 100.0) - bonds),
-                            to_string(total * (float(desired.cash) / 100.0) - cash),
+                            to_string(percentage(total, desired.int_stocks) - int_stocks),
+                            to_string(percentage(total, desired.dom_stocks) - dom_stocks),
+                            to_string(percentage(total, desired.bonds) - bonds),
+                            to_string(percentage(total, desired.cash) - cash),
                             to_string(budget::money{}),
                             get_default_currency()});
     }
@@ -948,8 +916,12 @@ void budget::add_asset_value(budget::asset_value&& asset_value){
     asset_values.add(std::forward<budget::asset_value>(asset_value));
 }
 
+std::vector<size_t> budget::add_asset_values(std::vector<budget::asset_value>&& new_asset_values){
+    return asset_values.add_all(std::move(new_asset_values));
+}
+
 void budget::list_asset_values(budget::writer& w){
-    if (!asset_values.data.size()) {
+    if (!asset_values.data().size()) {
         w << "No asset values" << end_of_line;
         return;
     }
@@ -959,7 +931,7 @@ void budget::list_asset_values(budget::writer& w){
 
     // Display the asset values
 
-    for(auto& value : asset_values.data){
+    for(auto& value : asset_values.data()){
         contents.push_back({to_string(value.id), get_asset(value.asset_id).name, to_string(value.amount), to_string(value.set_date), "::edit::asset_values::" + budget::to_string(value.id)});
     }
 
@@ -967,77 +939,121 @@ void budget::list_asset_values(budget::writer& w){
 }
 
 budget::money budget::get_portfolio_value(){
-    std::map<size_t, budget::money> asset_amounts;
-
-    for (auto& asset_value : all_sorted_asset_values()) {
-        auto& asset = get_asset(asset_value.asset_id);
+    budget::money total;
 
+    for (auto& asset : all_assets()) {
         if (asset.portfolio) {
-            asset_amounts[asset_value.asset_id] = asset_value.amount * exchange_rate(asset.currency, get_default_currency());
+            if (auto* asset_value = asset_values.last_asset_entry(asset.id)) {
+                total += convert(asset_value->amount, asset.currency);
+            }
         }
     }
 
-    budget::money total;
-
-    for (auto& asset_amount : asset_amounts) {
-        total += asset_amount.second;
-    }
-
     return total;
 }
 
 budget::money budget::get_net_worth(){
-    std::map<size_t, budget::money> asset_amounts;
-
-    for (auto& asset_value : all_sorted_asset_values()) {
-        auto& asset = get_asset(asset_value.asset_id);
-        asset_amounts[asset_value.asset_id] = asset_value.amount * exchange_rate(asset.currency, get_default_currency());
-    }
-
     budget::money total;
 
-    for (auto& asset_amount : asset_amounts) {
-        total += asset_amount.second;
+    for (auto& asset : all_assets()) {
+        if (auto* asset_value = asset_values.last_asset_entry(asset.id)) {
+            total += convert(asset_value->amount, asset.currency);
+        }
     }
 
     return total;
 }
 
 budget::money budget::get_net_worth(budget::date d){
-    std::map<size_t, budget::money> asset_amounts;
+    budget::money total;
 
-    for (auto& asset_value : all_sorted_asset_values()) {
-        if (asset_value.set_date <= d) {
-            auto& asset = get_asset(asset_value.asset_id);
-            asset_amounts[asset_value.asset_id] = asset_value.amount * exchange_rate(asset.currency, get_default_currency());
+    // The current rates are used until the history is known
+    prefetch_asset_exchange_rates();
+
+    budget::currency_converter converter;
+
+    for (auto& asset : all_assets()) {
+        if (auto* asset_value = asset_values.last_asset_entry(asset.id, d)) {
+            total += converter.convert(asset_value->amount, asset.currency, d);
         }
     }
 
+    return total;
+}
+
+budget::money budget::get_net_worth_cash(){
     budget::money total;
 
-    for (auto& asset_amount : asset_amounts) {
-        total += asset_amount.second;
+    for (auto& asset : all_assets()) {
+        if (asset.cash == budget::money(100)) {
+            if (auto* asset_value = asset_values.last_asset_entry(asset.id)) {
+                total += convert(asset_value->amount, asset.currency);
+            }
+        }
     }
 
     return total;
 }
 
-budget::money budget::get_net_worth_cash(){
+std::vector<budget::net_worth_point> budget::net_worth_series(){
+    // The totals of the assets in a currency
+    struct currency_totals {
+        budget::money net_worth;
+        budget::money portfolio;
+        budget::money cash;
+    };
+
+    std::vector<net_worth_point> series;
+
     std::map<size_t, budget::money> asset_amounts;
+    std::map<std::string, currency_totals> totals;
+
+    // The current rates are used until the history is known
+    prefetch_asset_exchange_rates();
+
+    budget::currency_converter converter;
+
+    auto sorted_asset_values = all_sorted_asset_values();
+
+    auto it  = sorted_asset_values.begin();
+    auto end = sorted_asset_values.end();
 
-    for (auto& asset_value : all_sorted_asset_values()) {
-        auto& asset = get_asset(asset_value.asset_id);
+    while (it != end) {
+        auto date = it->set_date;
 
-        if(asset.cash == budget::money(100)){
-            asset_amounts[asset_value.asset_id] = asset_value.amount * exchange_rate(asset.currency, get_default_currency());
+        // Replace the previous amounts of the assets in the totals
+        for (; it != end && it->set_date == date; ++it) {
+            auto& asset    = get_asset(it->asset_id);
+            auto& amount   = asset_amounts[it->asset_id];
+            auto& currency = totals[asset.currency];
+
+            auto difference = it->amount - amount;
+
+            currency.net_worth += difference;
+
+            if (asset.portfolio) {
+                currency.portfolio += difference;
+            }
+
+            if (asset.cash == budget::money(100)) {
+                currency.cash += difference;
+            }
+
+            amount = it->amount;
         }
-    }
 
-    budget::money total;
+        net_worth_point point{date, {}, {}, {}};
 
-    for (auto& asset_amount : asset_amounts) {
-        total += asset_amount.second;
+        for (auto& currency : totals) {
+            budget::fixed_rate rate(converter.rate(currency.first, date));
+
+            point.net_worth += multiply(currency.second.net_worth, rate);
+            point.portfolio += multiply(currency.second.portfolio, rate);
+            point.cash += multiply(currency.second.cash, rate);
+        }
+
+        series.push_back(point);
     }
 
-    return total;
+    return series;
 }
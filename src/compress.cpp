@@ -0,0 +1,101 @@
+//=======================================================================
+// Copyright (c) 2013-2018 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <algorithm>
+
+#include <zlib.h>
+
+#include "compress.hpp"
+
+using namespace budget;
+
+namespace {
+
+// 15 bits of window, +16 for the gzip header instead of the zlib one
+constexpr int gzip_window_bits = 15 + 16;
+
+// zlib works on unsigned int sizes, the data is given to it in blocks
+constexpr size_t block_size = 1 << 20;
+
+} // end of anonymous namespace
+
+bool budget::gzip_compress(const std::string& data, std::string& compressed){
+    z_stream stream{};
+
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, gzip_window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+
+    compressed.clear();
+    compressed.reserve(data.size() / 4);
+
+    auto next = reinterpret_cast<const Bytef*>(data.data());
+    auto left = data.size();
+
+    char buffer[16384];
+    int status = Z_OK;
+
+    while (status == Z_OK) {
+        if (!stream.avail_in && left) {
+            stream.next_in  = const_cast<Bytef*>(next);
+            stream.avail_in = static_cast<uInt>(std::min(left, block_size));
+
+            next += stream.avail_in;
+            left -= stream.avail_in;
+        }
+
+        stream.next_out  = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = sizeof(buffer);
+
+        status = deflate(&stream, left ? Z_NO_FLUSH : Z_FINISH);
+
+        compressed.append(buffer, sizeof(buffer) - stream.avail_out);
+    }
+
+    deflateEnd(&stream);
+
+    return status == Z_STREAM_END;
+}
+
+bool budget::gzip_decompress(const std::string& compressed, std::string& data){
+    z_stream stream{};
+
+    if (inflateInit2(&stream, gzip_window_bits) != Z_OK) {
+        return false;
+    }
+
+    data.clear();
+    data.reserve(compressed.size() * 4);
+
+    auto next = reinterpret_cast<const Bytef*>(compressed.data());
+    auto left = compressed.size();
+
+    char buffer[16384];
+    int status = Z_OK;
+
+    while (status == Z_OK) {
+        // When the data is truncated, inflate stops with Z_BUF_ERROR
+        if (!stream.avail_in && left) {
+            stream.next_in  = const_cast<Bytef*>(next);
+            stream.avail_in = static_cast<uInt>(std::min(left, block_size));
+
+            next += stream.avail_in;
+            left -= stream.avail_in;
+        }
+
+        stream.next_out  = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = sizeof(buffer);
+
+        status = inflate(&stream, Z_NO_FLUSH);
+
+        data.append(buffer, sizeof(buffer) - stream.avail_out);
+    }
+
+    inflateEnd(&stream);
+
+    return status == Z_STREAM_END;
+}
@@ -6,6 +6,7 @@
 //=======================================================================
 
 #include <utility>
+#include <algorithm>
 
 #include "compute.hpp"
 #include "expenses.hpp"
@@ -26,17 +27,12 @@ budget::status budget::compute_year_status(year year, month month){
 
     auto sm = start_month(year);
 
-    for(auto& expense : all_expenses()){
-        if(expense.date.year() == year && expense.date.month() >= sm && expense.date.month() <= month){
-            status.expenses += expense.amount;
-        }
+    for(auto& expense : all_expenses_between(year, sm, year, month)){
+        status.expenses += expense.amount;
     }
 
-    budget::money year_earnings;
-    for(auto& earning : all_earnings()){
-        if(earning.date.year() == year && earning.date.month() >= sm && earning.date.month() <= month){
-            status.earnings += earning.amount;
-        }
+    for(auto& earning : all_earnings_between(year, sm, year, month)){
+        status.earnings += earning.amount;
     }
 
     for(unsigned short i = sm; i <= month; ++i){
@@ -65,17 +61,8 @@ budget::status budget::compute_month_status(month month){
 budget::status budget::compute_month_status(year year, month month){
     budget::status status;
 
-    for(auto& expense : all_expenses()){
-        if(expense.date.year() == year && expense.date.month() == month){
-            status.expenses += expense.amount;
-        }
-    }
-
-    for(auto& earning : all_earnings()){
-        if(earning.date.year() == year && earning.date.month() == month){
-            status.earnings += earning.amount;
-        }
-    }
+    status.expenses = expenses_total(year, month);
+    status.earnings = earnings_total(year, month);
 
     for(auto& c : all_accounts(year, month)){
         status.budget += c.amount;
@@ -117,3 +104,56 @@ budget::status budget::compute_avg_month_status(year year, month month){
 
     return std::move(avg_status);
 }
+
+budget::monthly_history budget::compute_monthly_history(budget::date from, budget::date to){
+    monthly_history history;
+
+    history.first = budget::date(from.year(), from.month(), 1);
+
+    size_t months = 0;
+
+    if (!(to < history.first)) {
+        months = (to.year() - from.year()) * 12 + to.month() - from.month() + 1;
+    }
+
+    history.income.resize(months);
+    history.expenses.resize(months);
+    history.savings_rate.resize(months);
+
+    for (size_t i = 0; i < months; ++i) {
+        auto d = history.month_date(i);
+
+        history.income[i]   = earnings_total(d.year(), d.month());
+        history.expenses[i] = expenses_total(d.year(), d.month());
+    }
+
+    // Each account adds its amount to the months where it is active
+    for (auto& account : all_accounts()) {
+        for (size_t i = 0; i < months; ++i) {
+            auto d = history.month_date(i) + budget::days(4);
+
+            if (account.since < d && account.until > d) {
+                history.income[i] += account.amount;
+            }
+        }
+    }
+
+    history.expenses_sums.resize(months + 1);
+    history.savings_rate_sums.resize(months + 1);
+
+    for (size_t i = 0; i < months; ++i) {
+        double savings_rate = 0.0;
+
+        // A month without income has no savings (this also keeps NaN out of the sums)
+        if (history.income[i]) {
+            savings_rate = std::max(0.0, (history.income[i] - history.expenses[i]) / history.income[i]);
+        }
+
+        history.savings_rate[i] = savings_rate;
+
+        history.expenses_sums[i + 1]     = history.expenses_sums[i] + history.expenses[i];
+        history.savings_rate_sums[i + 1] = history.savings_rate_sums[i] + savings_rate;
+    }
+
+    return history;
+}
@@ -8,6 +8,7 @@
 #include <iostream>
 #include <fstream>
 #include <unordered_map>
+#include <memory>
 
 #include <unistd.h>    //for getuid
 #include <sys/types.h> //for getuid
@@ -112,6 +113,13 @@ static config_type configuration;
 static config_type internal;
 static config_type internal_bak;
 
+// Copy of the internal configuration pinned by the current thread
+static thread_local std::unique_ptr<config_type> pinned_internal;
+
+static config_type& current_internal(){
+    return pinned_internal ? *pinned_internal : internal;
+}
+
 bool budget::load_config(){
     if(!load_configuration(path_to_home_file(".budgetrc"), configuration)){
         return false;
@@ -199,15 +207,24 @@ bool budget::config_contains_and_true(const std::string& key) {
 }
 
 bool budget::internal_config_contains(const std::string& key){
-    return internal.find(key) != internal.end();
+    auto& current = current_internal();
+    return current.find(key) != current.end();
 }
 
 std::string& budget::internal_config_value(const std::string& key){
-    return internal[key];
+    return current_internal()[key];
 }
 
 void budget::internal_config_remove(const std::string& key){
-    internal.erase(key);
+    current_internal().erase(key);
+}
+
+void budget::pin_internal_config(){
+    pinned_internal = std::make_unique<config_type>(internal);
+}
+
+void budget::unpin_internal_config(){
+    pinned_internal.reset();
 }
 
 std::string budget::get_web_user(){
@@ -272,3 +289,29 @@ bool budget::net_worth_over_fortune(){
 
     return all_asset_values().size() && !all_fortunes().size();
 }
+
+size_t budget::journal_compaction_threshold(){
+    if (config_contains("journal_compaction")) {
+        auto threshold = to_number<size_t>(config_value("journal_compaction"));
+
+        if (threshold) {
+            return threshold;
+        }
+    }
+
+    return 1000;
+}
+
+durability budget::get_durability(){
+    if (config_contains("data_durability")) {
+        auto value = config_value("data_durability");
+
+        if (value == "none") {
+            return durability::none;
+        } else if (value == "write") {
+            return durability::write;
+        }
+    }
+
+    return durability::batch;
+}
@@ -6,21 +6,334 @@
 //=======================================================================
 
 #include <map>
+#include <set>
+#include <algorithm>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <future>
 #include <utility>
+#include <fstream>
 #include <iostream>
 
 #include "currency.hpp"
 #include "assets.hpp"
+#include "config.hpp"
+#include "server.hpp"
+#include "utils.hpp"
 #include "http.hpp"
 
 namespace {
 
-std::map<std::pair<std::string, std::string>, double> exchanges;
+using currency_pair = std::pair<std::string, std::string>;
+
+struct http_exchange_rate_provider : budget::exchange_rate_provider {
+    bool get_rate(const std::string& from, const std::string& to, budget::date date, double& rate) override {
+        httplib::Client cli("free.currencyconverterapi.com", 80);
+
+        std::string api_complete = "/api/v3/convert?q=" + from + "_" + to + "&compact=ultra";
+
+        if (date != budget::local_day()) {
+            api_complete += "&date=" + budget::date_to_string(date);
+        }
+
+        auto res = cli.get(api_complete.c_str());
+
+        if (!res || res->status != 200) {
+            return false;
+        }
+
+        auto& buffer = res->body;
+
+        if (buffer.find(':') == std::string::npos || buffer.find('}') == std::string::npos) {
+            return false;
+        }
+
+        // With a date, the rate is nested in another object
+        auto last = buffer.find('}');
+        auto first = buffer.rfind(':', last);
+
+        std::string ratio_result(buffer.begin() + first + 1, buffer.begin() + last);
+
+        rate = atof(ratio_result.c_str());
+
+        return rate > 0.0;
+    }
+};
+
+struct file_exchange_rate_provider : budget::exchange_rate_provider {
+    explicit file_exchange_rate_provider(const std::string& path){
+        std::ifstream file(path);
+        std::string line;
+
+        while (std::getline(file, line)) {
+            auto parts = budget::split(line, ':');
+
+            if (parts.size() == 4) {
+                try {
+                    rates[{parts[0], parts[1]}][budget::from_string(parts[2])] = budget::to_number<double>(parts[3]);
+                } catch (const budget::date_exception&) {
+                    // Ignore the invalid lines
+                }
+            }
+        }
+    }
+
+    bool get_rate(const std::string& from, const std::string& to, budget::date date, double& rate) override {
+        if (get_direct_rate(from, to, date, rate)) {
+            return true;
+        }
+
+        if (get_direct_rate(to, from, date, rate)) {
+            rate = 1.0 / rate;
+            return true;
+        }
+
+        return false;
+    }
+
+    void local_rates(const std::string& from, const std::string& to, std::vector<std::pair<budget::date, double>>& result) override {
+        auto it = rates.find({from, to});
+
+        if (it != rates.end()) {
+            for (auto& value : it->second) {
+                result.emplace_back(value.first, value.second);
+            }
+        }
+
+        auto reverse_it = rates.find({to, from});
+
+        if (reverse_it != rates.end()) {
+            for (auto& value : reverse_it->second) {
+                result.emplace_back(value.first, 1.0 / value.second);
+            }
+        }
+    }
+
+private:
+    std::map<currency_pair, std::map<budget::date, double>> rates;
+
+    // Returns the last rate known at the given date
+    bool get_direct_rate(const std::string& from, const std::string& to, budget::date date, double& rate) {
+        auto it = rates.find({from, to});
+
+        if (it == rates.end()) {
+            return false;
+        }
+
+        auto next = it->second.upper_bound(date);
+
+        if (next == it->second.begin()) {
+            return false;
+        }
+
+        rate = std::prev(next)->second;
+
+        return true;
+    }
+};
+
+struct cached_rate {
+    double rate;
+    std::time_t fetched; // When the rate was obtained from the provider
+};
+
+struct exchange_cache {
+    std::mutex lock;
+
+    bool loaded = false;
+    std::map<currency_pair, std::map<budget::date, cached_rate>> rates;
+
+    // The rates obtained before are stale
+    std::time_t invalidated = 0;
+
+    // The pairs being refreshed in the background
+    std::set<currency_pair> refreshing;
+
+    // The pairs that could not be obtained, set to 1/1 until invalidation
+    std::set<currency_pair> failed;
+
+    // The historical rates that could not be obtained, not tried again
+    std::set<std::pair<currency_pair, budget::date>> failed_history;
+
+    std::shared_ptr<budget::exchange_rate_provider> provider;
+};
+
+// Never destroyed since the background refreshes may outlive main
+exchange_cache& cache(){
+    static auto* cache = new exchange_cache();
+    return *cache;
+}
+
+std::string cache_path(){
+    return budget::path_to_budget_file("exchanges.data");
+}
+
+// Must be called with the lock held
+std::shared_ptr<budget::exchange_rate_provider> get_provider(exchange_cache& cache){
+    if (!cache.provider) {
+        if (budget::config_contains("exchange_rates_file")) {
+            cache.provider = std::make_shared<file_exchange_rate_provider>(budget::config_value("exchange_rates_file"));
+        } else {
+            cache.provider = std::make_shared<http_exchange_rate_provider>();
+        }
+    }
+
+    return cache.provider;
+}
+
+// Must be called with the lock held
+void load_cache(exchange_cache& cache){
+    if (cache.loaded) {
+        return;
+    }
+
+    cache.loaded = true;
+
+    std::ifstream file(cache_path());
+    std::string line;
+
+    while (std::getline(file, line)) {
+        auto parts = budget::split(line, ':');
+
+        if (parts.size() == 5) {
+            try {
+                auto date = budget::from_string(parts[2]);
+
+                cached_rate value;
+                value.rate    = budget::to_number<double>(parts[3]);
+                value.fetched = budget::to_number<std::time_t>(parts[4]);
+
+                cache.rates[{parts[0], parts[1]}][date] = value;
+            } catch (const budget::date_exception&) {
+                // Ignore the invalid lines
+            } catch (const budget::budget_exception&) {
+                // Ignore the invalid lines (number too big)
+            }
+        }
+    }
+}
+
+// Must be called with the lock held
+void save_cache(exchange_cache& cache){
+    if (budget::config_contains("random")) {
+        return;
+    }
+
+    auto path     = cache_path();
+    auto tmp_path = path + ".tmp";
+
+    {
+        std::ofstream file(tmp_path);
+
+        for (auto& pair : cache.rates) {
+            for (auto& value : pair.second) {
+                file << pair.first.first << ':' << pair.first.second << ':' << budget::date_to_string(value.first) << ':'
+                     << budget::to_string_precision(value.second.rate, 10) << ':' << value.second.fetched << '\n';
+            }
+        }
+    }
+
+    budget::replace_file(tmp_path, path, false);
+}
+
+// Must be called with the lock held
+void store_rate(exchange_cache& cache, const currency_pair& pair, budget::date date, double rate){
+    auto now = std::time(nullptr);
+
+    cache.rates[pair][date]                      = {rate, now};
+    cache.rates[{pair.second, pair.first}][date] = {1.0 / rate, now};
+
+    cache.failed.erase(pair);
+}
+
+// Must be called with the lock held
+bool is_fresh(exchange_cache& cache, const std::map<budget::date, cached_rate>& rates, budget::date today){
+    auto& latest = *rates.rbegin();
+    return latest.first == today && latest.second.fetched >= cache.invalidated;
+}
+
+// Must be called with the lock held
+bool must_fetch(exchange_cache& cache, const currency_pair& pair, budget::date today){
+    auto it = cache.rates.find(pair);
+
+    if (it != cache.rates.end() && !it->second.empty()) {
+        // The server serves the stale rate while it is refreshed
+        return !is_fresh(cache, it->second, today) && !budget::is_server_running();
+    }
+
+    return !cache.failed.count(pair);
+}
+
+// Must be called with the lock held, when the provider could not give the rate
+double failed_rate(exchange_cache& cache, const currency_pair& pair){
+    // Use the stale rate if there is one
+    auto it = cache.rates.find(pair);
+
+    if (it != cache.rates.end() && !it->second.empty()) {
+        return it->second.rbegin()->second.rate;
+    }
+
+    std::cout << "Error accessing exchange rates, setting exchange between " << pair.first << " to " << pair.second << " to 1/1" << std::endl;
+
+    cache.failed.insert(pair);
+
+    return 1.0;
+}
+
+void refresh_in_background(exchange_cache& cache, const currency_pair& pair, budget::date date){
+    if (cache.refreshing.count(pair)) {
+        return;
+    }
+
+    cache.refreshing.insert(pair);
+
+    auto provider = get_provider(cache);
+
+    std::thread([&cache, provider, pair, date]() {
+        double rate  = 1.0;
+        bool success = provider->get_rate(pair.first, pair.second, date, rate);
+
+        std::lock_guard<std::mutex> lock(cache.lock);
+
+        if (success) {
+            store_rate(cache, pair, date, rate);
+            save_cache(cache);
+        }
+
+        cache.refreshing.erase(pair);
+    }).detach();
+}
+
+// Number of days since 1970-01-01
+long day_number(budget::date d){
+    long y   = d.year() - (d.month() <= 2 ? 1 : 0);
+    long m   = d.month();
+    long era = y / 400;
+    long yoe = y - era * 400;
+    long doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d.day() - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + doe - 719468;
+}
 
 } // end of anonymous namespace
 
+void budget::set_exchange_rate_provider(std::unique_ptr<exchange_rate_provider> provider){
+    auto& cache = ::cache();
+
+    std::lock_guard<std::mutex> lock(cache.lock);
+
+    cache.provider = std::move(provider);
+}
+
 void budget::invalidate_currency_cache(){
-    exchanges.clear();
+    auto& cache = ::cache();
+
+    std::lock_guard<std::mutex> lock(cache.lock);
+
+    cache.invalidated = std::time(nullptr);
+    cache.failed.clear();
 }
 
 double budget::exchange_rate(const std::string& from){
@@ -30,41 +343,269 @@ double budget::exchange_rate(const std::string& from){
 double budget::exchange_rate(const std::string& from, const std::string& to){
     if(from == to){
         return 1.0;
-    } else {
-        auto key = std::make_pair(from, to);
-        auto reverse_key = std::make_pair(to, from);
+    }
 
-        if (!exchanges.count(key)) {
-            httplib::Client cli("free.currencyconverterapi.com", 80);
+    auto& cache = ::cache();
+    auto pair   = std::make_pair(from, to);
+    auto today  = budget::local_day();
 
-            std::string api_complete = "/api/v3/convert?q=" + from + "_" + to + "&compact=ultra";
+    std::shared_ptr<exchange_rate_provider> provider;
 
-            auto res = cli.get(api_complete.c_str());
+    {
+        std::lock_guard<std::mutex> lock(cache.lock);
 
-            if (!res) {
-                std::cout << "Error accessing exchange rates (no response), setting exchange between " << from << " to " << to << " to 1/1" << std::endl;
+        load_cache(cache);
 
-                exchanges[key] = 1.0;
-            } else if (res->status != 200) {
-                std::cout << "Error accessing exchange rates (not OK), setting exchange between " << from << " to " << to << " to 1/1" << std::endl;
+        if (!must_fetch(cache, pair, today)) {
+            auto it = cache.rates.find(pair);
 
-                exchanges[key] = 1.0;
-            } else {
-                auto& buffer = res->body;
+            if (it == cache.rates.end() || it->second.empty()) {
+                return 1.0;
+            }
 
-                if (buffer.find(':') == std::string::npos || buffer.find('}') == std::string::npos) {
-                    std::cout << "Error parsing exchange rates, setting exchange between " << from << " to " << to << " to 1/1" << std::endl;
+            if (!is_fresh(cache, it->second, today)) {
+                refresh_in_background(cache, pair, today);
+            }
+
+            return it->second.rbegin()->second.rate;
+        }
+
+        provider = get_provider(cache);
+    }
+
+    // The rate is fetched without holding the lock
+
+    double rate  = 1.0;
+    bool success = provider->get_rate(from, to, today, rate);
+
+    std::lock_guard<std::mutex> lock(cache.lock);
+
+    if (success) {
+        store_rate(cache, pair, today, rate);
+        save_cache(cache);
+
+        return rate;
+    }
+
+    return failed_rate(cache, pair);
+}
+
+budget::money budget::convert(budget::money amount, const std::string& from){
+    return convert(amount, from, get_default_currency());
+}
+
+budget::money budget::convert(budget::money amount, const std::string& from, const std::string& to){
+    return multiply(amount, fixed_rate(exchange_rate(from, to)));
+}
 
-                    exchanges[key] = 1.0;
-                } else {
-                    std::string ratio_result(buffer.begin() + buffer.find(':') + 1, buffer.begin() + buffer.find('}'));
+void budget::prefetch_exchange_rates(const std::vector<std::pair<std::string, std::string>>& pairs){
+    auto& cache = ::cache();
+    auto today  = budget::local_day();
 
-                    exchanges[key]         = atof(ratio_result.c_str());
-                    exchanges[reverse_key] = 1.0 / exchanges[key];
+    std::vector<currency_pair> missing;
+    std::shared_ptr<exchange_rate_provider> provider;
+
+    {
+        std::lock_guard<std::mutex> lock(cache.lock);
+
+        load_cache(cache);
+
+        for (auto& pair : pairs) {
+            if (pair.first != pair.second && must_fetch(cache, pair, today)) {
+                if (std::find(missing.begin(), missing.end(), pair) == missing.end()) {
+                    missing.push_back(pair);
                 }
             }
         }
 
-        return exchanges[key];
+        provider = get_provider(cache);
+    }
+
+    if (missing.empty()) {
+        return;
+    }
+
+    // All the rates are fetched at the same time, without holding the lock
+
+    std::vector<std::future<std::pair<bool, double>>> results;
+
+    for (auto& pair : missing) {
+        results.push_back(std::async(std::launch::async, [provider, pair, today]() {
+            double rate  = 1.0;
+            bool success = provider->get_rate(pair.first, pair.second, today, rate);
+            return std::make_pair(success, rate);
+        }));
+    }
+
+    std::lock_guard<std::mutex> lock(cache.lock);
+
+    bool changed = false;
+
+    for (size_t i = 0; i < missing.size(); ++i) {
+        auto result = results[i].get();
+
+        if (result.first) {
+            store_rate(cache, missing[i], today, result.second);
+            changed = true;
+        } else {
+            failed_rate(cache, missing[i]);
+        }
+    }
+
+    if (changed) {
+        save_cache(cache);
     }
 }
+
+void budget::fetch_exchange_rate_history(const std::string& from, const std::string& to, budget::date first){
+    if (from == to) {
+        return;
+    }
+
+    auto& cache = ::cache();
+    auto pair   = std::make_pair(from, to);
+    auto today  = budget::local_day();
+
+    std::vector<budget::date> missing;
+    std::shared_ptr<exchange_rate_provider> provider;
+
+    {
+        std::lock_guard<std::mutex> lock(cache.lock);
+
+        load_cache(cache);
+
+        provider = get_provider(cache);
+
+        auto it = cache.rates.find(pair);
+
+        for (budget::date d(first.year(), first.month(), 1); d < today; d += budget::months(1)) {
+            if ((it == cache.rates.end() || !it->second.count(d)) && !cache.failed_history.count({pair, d})) {
+                missing.push_back(d);
+            }
+        }
+    }
+
+    if (missing.empty()) {
+        return;
+    }
+
+    // The provider may already know the history without the network
+    std::vector<std::pair<budget::date, double>> local;
+    provider->local_rates(from, to, local);
+
+    if (!local.empty()) {
+        return;
+    }
+
+    // The rates are fetched one at a time, without holding the lock, to
+    // not overload the provider
+
+    bool changed = false;
+
+    for (auto& d : missing) {
+        double rate  = 1.0;
+        bool success = provider->get_rate(from, to, d, rate);
+
+        std::lock_guard<std::mutex> lock(cache.lock);
+
+        if (success) {
+            store_rate(cache, pair, d, rate);
+            changed = true;
+        } else {
+            cache.failed_history.insert({pair, d});
+        }
+    }
+
+    if (changed) {
+        std::lock_guard<std::mutex> lock(cache.lock);
+        save_cache(cache);
+    }
+}
+
+double budget::exchange_rate(const std::string& from, const std::string& to, budget::date d){
+    return exchange_rate_history(from, to).rate(d);
+}
+
+budget::exchange_rate_history::exchange_rate_history(const std::string& from, const std::string& to){
+    if (from == to) {
+        return;
+    }
+
+    auto& cache = ::cache();
+
+    std::vector<std::pair<budget::date, double>> rates;
+    std::shared_ptr<exchange_rate_provider> provider;
+
+    {
+        std::lock_guard<std::mutex> lock(cache.lock);
+
+        load_cache(cache);
+
+        auto it = cache.rates.find({from, to});
+
+        if (it != cache.rates.end()) {
+            for (auto& value : it->second) {
+                rates.emplace_back(value.first, value.second.rate);
+            }
+        }
+
+        provider = get_provider(cache);
+    }
+
+    provider->local_rates(from, to, rates);
+
+    // No rate is known yet, they are obtained in the background. The
+    // current rate is used in the meantime.
+    if (rates.empty()) {
+        default_rate = exchange_rate(from, to);
+        return;
+    }
+
+    points.reserve(rates.size());
+
+    for (auto& rate : rates) {
+        points.emplace_back(day_number(rate.first), rate.second);
+    }
+
+    // The cached rates take precedence over the local rates of the provider
+    std::stable_sort(points.begin(), points.end(), [](auto& lhs, auto& rhs) { return lhs.first < rhs.first; });
+
+    auto last = std::unique(points.begin(), points.end(), [](auto& lhs, auto& rhs) { return lhs.first == rhs.first; });
+    points.erase(last, points.end());
+}
+
+double budget::exchange_rate_history::rate(budget::date d) const {
+    if (points.empty()) {
+        return default_rate;
+    }
+
+    auto day  = day_number(d);
+    auto next = std::lower_bound(points.begin(), points.end(), day, [](auto& point, long day) { return point.first < day; });
+
+    if (next == points.begin()) {
+        return next->second;
+    }
+
+    if (next == points.end()) {
+        return points.back().second;
+    }
+
+    if (next->first == day) {
+        return next->second;
+    }
+
+    auto prev   = std::prev(next);
+    auto factor = double(day - prev->first) / double(next->first - prev->first);
+
+    return prev->second + factor * (next->second - prev->second);
+}
+
+double budget::currency_converter::rate(const std::string& currency, budget::date d){
+    auto it = histories.find(currency);
+
+    if (it == histories.end()) {
+        it = histories.emplace(currency, exchange_rate_history(currency, get_default_currency())).first;
+    }
+
+    return it->second.rate(d);
+}
@@ -0,0 +1,187 @@
+//=======================================================================
+// Copyright (c) 2013-2018 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <functional>
+#include <unordered_map>
+
+#include "data.hpp"
+#include "config.hpp"
+#include "guid.hpp"
+
+using namespace budget;
+
+namespace {
+
+struct registered_handler {
+    std::string module;
+    std::function<void()> pin;
+    std::function<void()> unpin;
+    std::function<size_t()> version;
+    std::function<void(std::ostream&, size_t)> changes;
+};
+
+// The handlers are registered during static initialization
+std::vector<registered_handler>& data_handlers(){
+    static std::vector<registered_handler> handlers;
+    return handlers;
+}
+
+registered_handler* find_handler(const std::string& module){
+    for (auto& handler : data_handlers()) {
+        if (handler.module == module) {
+            return &handler;
+        }
+    }
+
+    return nullptr;
+}
+
+// The rows of all the modules, obtained from the server
+struct synced_module {
+    size_t first;        // The first character of the rows in the body
+    size_t last;         // The end of the rows in the body
+    std::string version; // The version of the rows, as epoch:version
+};
+
+struct synced_data {
+    std::mutex lock;
+    bool done = false;
+    std::string body;
+    std::unordered_map<std::string, synced_module> modules;
+};
+
+synced_data& synced(){
+    static synced_data data;
+    return data;
+}
+
+void synchronize(synced_data& data){
+    data.done = true;
+
+    // Older servers do not support it, the modules are then loaded one by one
+    auto res = api_get("/sync/", true);
+
+    if (!res.success) {
+        return;
+    }
+
+    data.body = std::move(res.result);
+
+    auto& body = data.body;
+
+    std::string module;
+    std::string version;
+    size_t start    = 0;
+    size_t position = 0;
+
+    while (position < body.size()) {
+        auto end = body.find('\n', position);
+
+        if (end == std::string::npos) {
+            end = body.size();
+        }
+
+        // The rows start with their id, only the modules start with #
+        // (#module:rows:epoch:version)
+        if (body[position] == '#') {
+            if (!module.empty()) {
+                data.modules[module] = {start, position, version};
+            }
+
+            auto line = body.substr(position + 1, end - position - 1);
+
+            auto rows_separator    = line.find(':');
+            auto version_separator = rows_separator == std::string::npos ? rows_separator : line.find(':', rows_separator + 1);
+
+            module  = line.substr(0, rows_separator);
+            version = version_separator == std::string::npos ? "" : line.substr(version_separator + 1);
+            start   = std::min(end + 1, body.size());
+        }
+
+        position = end + 1;
+    }
+
+    if (!module.empty()) {
+        data.modules[module] = {start, body.size(), version};
+    }
+}
+
+} //end of anonymous namespace
+
+void budget::register_data_handler(const char* module, std::function<void()> pin, std::function<void()> unpin,
+                                   std::function<size_t()> version, std::function<void(std::ostream&, size_t)> changes){
+    data_handlers().push_back({module, std::move(pin), std::move(unpin), std::move(version), std::move(changes)});
+}
+
+const std::string& budget::data_epoch(){
+    // The versions of the data are only valid during the life of the process
+    static const std::string epoch = generate_guid();
+    return epoch;
+}
+
+size_t budget::module_version(const std::string& module){
+    auto handler = find_handler(module);
+    return handler ? handler->version() : 0;
+}
+
+bool budget::write_module_changes(const std::string& module, std::ostream& out, size_t since){
+    auto handler = find_handler(module);
+
+    if (!handler) {
+        return false;
+    }
+
+    handler->changes(out, since);
+
+    return true;
+}
+
+budget::pinned_data::pinned_data(){
+    pin_internal_config();
+
+    for (auto& handler : data_handlers()) {
+        handler.pin();
+    }
+}
+
+budget::pinned_data::~pinned_data(){
+    for (auto& handler : data_handlers()) {
+        handler.unpin();
+    }
+
+    unpin_internal_config();
+}
+
+bool budget::load_synced_rows(const std::string& module, const std::function<void(const char*, const char*, const std::string&)>& parse){
+    auto& data = synced();
+
+    std::lock_guard<std::mutex> lock(data.lock);
+
+    if (!data.done) {
+        synchronize(data);
+    }
+
+    auto it = data.modules.find(module);
+
+    if (it == data.modules.end()) {
+        return false;
+    }
+
+    parse(data.body.data() + it->second.first, data.body.data() + it->second.last, it->second.version);
+
+    data.modules.erase(it);
+
+    // The rows are not needed anymore once all the modules are loaded
+    if (data.modules.empty()) {
+        std::string().swap(data.body);
+    }
+
+    return true;
+}
@@ -13,6 +13,18 @@
 #include "expenses.hpp"
 #include "earnings.hpp"
 
+namespace {
+
+// Parse a field of a date, without allocating a sub string
+budget::date_type date_field(const std::string& str, size_t pos, size_t n){
+    auto first = str.data() + std::min(pos, str.size());
+    auto last  = str.data() + std::min(pos + n, str.size());
+
+    return budget::to_number<budget::date_type>(first, last);
+}
+
+} // end of anonymous namespace
+
 budget::date budget::local_day(){
     auto tt = time( NULL );
     auto timeval = localtime( &tt );
@@ -24,17 +36,17 @@ budget::date budget::local_day(){
 }
 
 budget::date budget::from_string(const std::string& str){
-    auto y = year(to_number<unsigned short>(str.substr(0, 4)));
-    auto m = month(to_number<unsigned short>(str.substr(5, 2)));
-    auto d = day(to_number<unsigned short>(str.substr(8, 2)));
+    auto y = year(date_field(str, 0, 4));
+    auto m = month(date_field(str, 5, 2));
+    auto d = day(date_field(str, 8, 2));
 
     return {y, m, d};
 }
 
 budget::date budget::from_iso_string(const std::string& str){
-    auto y = year(to_number<unsigned short>(str.substr(0, 4)));
-    auto m = month(to_number<unsigned short>(str.substr(4, 2)));
-    auto d = day(to_number<unsigned short>(str.substr(6, 2)));
+    auto y = year(date_field(str, 0, 4));
+    auto m = month(date_field(str, 4, 2));
+    auto d = day(date_field(str, 6, 2));
 
     return {y, m, d};
 }
@@ -48,16 +60,18 @@ std::string budget::date_to_string(budget::date date){
 unsigned short budget::start_month(budget::year year){
     budget::month m = 12;
 
-    for(auto& expense : all_expenses()){
-        if(expense.date.year() == year){
-            m = std::min(expense.date.month(), m);
-        }
+    // The ranges are sorted by month, only the first entry matters
+
+    auto expenses = all_expenses_between(year, 1, year, 12);
+
+    if(!expenses.empty()){
+        m = std::min(expenses.begin()->date.month(), m);
     }
 
-    for(auto& earning : all_earnings()){
-        if(earning.date.year() == year){
-            m = std::min(earning.date.month(), m);
-        }
+    auto earnings = all_earnings_between(year, 1, year, 12);
+
+    if(!earnings.empty()){
+        m = std::min(earnings.begin()->date.month(), m);
     }
 
     return m;
@@ -159,8 +159,45 @@ void budget::operator>>(const std::vector<std::string>& parts, earning& earning)
     }
 }
 
+snapshot_writer& budget::operator<<(snapshot_writer& writer, const earning& earning){
+    return writer << earning.id << earning.guid << earning.account << earning.name << earning.amount << earning.date;
+}
+
+snapshot_reader& budget::operator>>(snapshot_reader& reader, earning& earning){
+    return reader >> earning.id >> earning.guid >> earning.account >> earning.name >> earning.amount >> earning.date;
+}
+
 std::vector<earning>& budget::all_earnings(){
-    return earnings.data;
+    return earnings.data();
+}
+
+data_range<earning> budget::all_earnings_month(budget::year year, budget::month month){
+    return earnings.month_range(year, month);
+}
+
+data_range<earning> budget::all_earnings_between(budget::year sy, budget::month sm, budget::year ey, budget::month em){
+    return earnings.month_range(sy, sm, ey, em);
+}
+
+budget::money budget::earnings_total(size_t account, budget::year year, budget::month month){
+    return earnings.account_total(account, year, month);
+}
+
+budget::money budget::earnings_total(const std::string& account_name, budget::year year, budget::month month){
+    budget::money total;
+
+    // The earnings can be attached to any version of the account
+    for (auto& account : all_accounts()) {
+        if (account.name == account_name) {
+            total += earnings.account_total(account.id, year, month);
+        }
+    }
+
+    return total;
+}
+
+budget::money budget::earnings_total(budget::year year, budget::month month){
+    return earnings.month_total(year, month);
 }
 
 void budget::set_earnings_changed(){
@@ -175,13 +212,21 @@ void budget::add_earning(budget::earning&& earning){
     earnings.add(std::forward<budget::earning>(earning));
 }
 
+std::vector<size_t> budget::add_earnings(std::vector<budget::earning>&& new_earnings){
+    return earnings.add_all(std::move(new_earnings));
+}
+
+bool budget::edit_earning(budget::earning& earning){
+    return earnings.edit(earning);
+}
+
 void budget::show_all_earnings(budget::writer& w){
     w << title_begin << "All Earnings " << add_button("earnings") << title_end;
 
     std::vector<std::string> columns = {"ID", "Date", "Account", "Name", "Amount"};
     std::vector<std::vector<std::string>> contents;
 
-    for(auto& earning : earnings.data){
+    for(auto& earning : earnings.data()){
         contents.push_back({to_string(earning.id), to_string(earning.date), get_account(earning.account).name, earning.name, to_string(earning.amount)});
     }
 
@@ -199,13 +244,11 @@ void budget::show_earnings(budget::month month, budget::year year, budget::write
     money total;
     size_t count = 0;
 
-    for(auto& earning : earnings.data){
-        if(earning.date.year() == year && earning.date.month() == month){
-            contents.push_back({to_string(earning.id), to_string(earning.date), get_account(earning.account).name, earning.name, to_string(earning.amount), "::edit::earnings::" + to_string(earning.id)});
+    for(auto& earning : earnings.month_range(year, month)){
+        contents.push_back({to_string(earning.id), to_string(earning.date), get_account(earning.account).name, earning.name, to_string(earning.amount), "::edit::earnings::" + to_string(earning.id)});
 
-            total += earning.amount;
-            ++count;
-        }
+        total += earning.amount;
+        ++count;
     }
 
     if(count == 0){
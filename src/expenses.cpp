@@ -32,7 +32,7 @@ void show_templates(){
 
     size_t count = 0;
 
-    for(auto& expense : expenses.data){
+    for(auto& expense : expenses.data()){
         if(expense.date == TEMPLATE_DATE){
             contents.push_back({to_string(expense.id), get_account(expense.account).name, expense.name, to_string(expense.amount)});
             ++count;
@@ -228,6 +228,10 @@ void budget::add_expense(budget::expense&& expense){
     expenses.add(std::forward<budget::expense>(expense));
 }
 
+std::vector<size_t> budget::add_expenses(std::vector<budget::expense>&& new_expenses){
+    return expenses.add_all(std::move(new_expenses));
+}
+
 bool budget::edit_expense(expense& expense){
     return expenses.edit(expense);
 }
@@ -252,8 +256,45 @@ void budget::operator>>(const std::vector<std::string>& parts, expense& expense)
     }
 }
 
+snapshot_writer& budget::operator<<(snapshot_writer& writer, const expense& expense){
+    return writer << expense.id << expense.guid << expense.account << expense.name << expense.amount << expense.date;
+}
+
+snapshot_reader& budget::operator>>(snapshot_reader& reader, expense& expense){
+    return reader >> expense.id >> expense.guid >> expense.account >> expense.name >> expense.amount >> expense.date;
+}
+
 std::vector<expense>& budget::all_expenses(){
-    return expenses.data;
+    return expenses.data();
+}
+
+data_range<expense> budget::all_expenses_month(budget::year year, budget::month month){
+    return expenses.month_range(year, month);
+}
+
+data_range<expense> budget::all_expenses_between(budget::year sy, budget::month sm, budget::year ey, budget::month em){
+    return expenses.month_range(sy, sm, ey, em);
+}
+
+budget::money budget::expenses_total(size_t account, budget::year year, budget::month month){
+    return expenses.account_total(account, year, month);
+}
+
+budget::money budget::expenses_total(const std::string& account_name, budget::year year, budget::month month){
+    budget::money total;
+
+    // The expenses can be attached to any version of the account
+    for (auto& account : all_accounts()) {
+        if (account.name == account_name) {
+            total += expenses.account_total(account.id, year, month);
+        }
+    }
+
+    return total;
+}
+
+budget::money budget::expenses_total(budget::year year, budget::month month){
+    return expenses.month_total(year, month);
 }
 
 void budget::set_expenses_changed(){
@@ -270,7 +311,7 @@ void budget::show_all_expenses(budget::writer& w){
     std::vector<std::string> columns = {"ID", "Date", "Account", "Name", "Amount", "Edit"};
     std::vector<std::vector<std::string>> contents;
 
-    for(auto& expense : expenses.data){
+    for(auto& expense : expenses.data()){
         contents.push_back({to_string(expense.id), to_string(expense.date), get_account(expense.account).name,
             expense.name, to_string(expense.amount), "::edit::expenses::" + to_string(expense.id)});
     }
@@ -290,7 +331,7 @@ void budget::search_expenses(const std::string& search, budget::writer& w){
     auto l_search = search;
     std::transform(l_search.begin(), l_search.end(), l_search.begin(), ::tolower);
 
-    for(auto& expense : expenses.data){
+    for(auto& expense : expenses.data()){
         auto l_name = expense.name;
         std::transform(l_name.begin(), l_name.end(), l_name.begin(), ::tolower);
 
@@ -322,13 +363,11 @@ void budget::show_expenses(budget::month month, budget::year year, budget::write
     money total;
     size_t count = 0;
 
-    for(auto& expense : expenses.data){
-        if(expense.date.year() == year && expense.date.month() == month){
-            contents.push_back({to_string(expense.id), to_string(expense.date), get_account(expense.account).name, expense.name, to_string(expense.amount), "::edit::expenses::" + to_string(expense.id)});
+    for(auto& expense : expenses.month_range(year, month)){
+        contents.push_back({to_string(expense.id), to_string(expense.date), get_account(expense.account).name, expense.name, to_string(expense.amount), "::edit::expenses::" + to_string(expense.id)});
 
-            total += expense.amount;
-            ++count;
-        }
+        total += expense.amount;
+        ++count;
     }
 
     if(count == 0){
@@ -5,6 +5,8 @@
 //  http://opensource.org/licenses/MIT)
 //=======================================================================
 
+#include <cctype>
+#include <cstdint>
 #include <stdexcept>
 #include <random>
 
@@ -14,30 +16,203 @@
 
 using namespace budget;
 
+namespace {
+
+// The intermediate products of the fixed-point operations do not always
+// fit on 64 bits, they are computed on 128 bits, as two unsigned halves
+struct wide {
+    uint64_t high;
+    uint64_t low;
+};
+
+uint64_t magnitude(long value){
+    return value < 0 ? uint64_t(0) - uint64_t(value) : uint64_t(value);
+}
+
+wide multiply_wide(uint64_t a, uint64_t b){
+    uint64_t a_low  = a & 0xFFFFFFFF;
+    uint64_t a_high = a >> 32;
+    uint64_t b_low  = b & 0xFFFFFFFF;
+    uint64_t b_high = b >> 32;
+
+    uint64_t low_low   = a_low * b_low;
+    uint64_t low_high  = a_low * b_high;
+    uint64_t high_low  = a_high * b_low;
+    uint64_t high_high = a_high * b_high;
+
+    uint64_t middle = (low_low >> 32) + (low_high & 0xFFFFFFFF) + (high_low & 0xFFFFFFFF);
+
+    wide result;
+    result.low  = (middle << 32) | (low_low & 0xFFFFFFFF);
+    result.high = high_high + (low_high >> 32) + (high_low >> 32) + (middle >> 32);
+    return result;
+}
+
+// The quotient must fit on 64 bits
+uint64_t divide_wide(wide numerator, uint64_t denominator, uint64_t& remainder){
+    if (!numerator.high) {
+        remainder = numerator.low % denominator;
+        return numerator.low / denominator;
+    }
+
+    uint64_t quotient = 0;
+    uint64_t rest     = numerator.high % denominator;
+
+    // Long division of the low half, one bit at a time
+    for (int bit = 63; bit >= 0; --bit) {
+        bool carry = rest >> 63;
+
+        rest = (rest << 1) | ((numerator.low >> bit) & 1);
+
+        if (carry || rest >= denominator) {
+            rest -= denominator;
+            quotient |= uint64_t(1) << bit;
+        }
+    }
+
+    remainder = rest;
+    return quotient;
+}
+
+// Returns a * b / denominator, rounded with the given mode
+long multiply_divide(long a, long b, long denominator, rounding mode){
+    bool negative = a && b && ((a < 0) != (b < 0)) != (denominator < 0);
+
+    uint64_t divisor = magnitude(denominator);
+    uint64_t remainder;
+    uint64_t quotient = divide_wide(multiply_wide(magnitude(a), magnitude(b)), divisor, remainder);
+
+    if (remainder) {
+        bool away = false;
+
+        switch (mode) {
+            case rounding::down:
+                break;
+            case rounding::floor:
+                away = negative;
+                break;
+            case rounding::ceil:
+                away = !negative;
+                break;
+            case rounding::nearest:
+                away = remainder >= divisor - remainder;
+                break;
+            case rounding::even:
+                away = remainder > divisor - remainder || (remainder == divisor - remainder && quotient % 2 != 0);
+                break;
+        }
+
+        if (away) {
+            ++quotient;
+        }
+    }
+
+    return negative ? -long(quotient) : long(quotient);
+}
+
+money from_cents(long cents){
+    money m;
+    m.value = cents;
+    return m;
+}
+
+} // end of anonymous namespace
+
+fixed_rate budget::fixed_rate::percent(money percentage){
+    fixed_rate rate;
+    rate.value = percentage.value * (RATE_SCALE / (100 * SCALE));
+    return rate;
+}
+
+fixed_rate budget::fixed_rate::ratio(money numerator, money denominator, rounding mode){
+    fixed_rate rate;
+
+    if (denominator.value) {
+        rate.value = multiply_divide(numerator.value, RATE_SCALE, denominator.value, mode);
+    }
+
+    return rate;
+}
+
+fixed_rate budget::fixed_rate::ratio(fixed_rate numerator, fixed_rate denominator, rounding mode){
+    fixed_rate rate;
+
+    if (denominator.value) {
+        rate.value = multiply_divide(numerator.value, RATE_SCALE, denominator.value, mode);
+    }
+
+    return rate;
+}
+
+money budget::multiply(money amount, fixed_rate rate, rounding mode){
+    return from_cents(multiply_divide(amount.value, rate.value, RATE_SCALE, mode));
+}
+
+money budget::percentage(money amount, money percentage, rounding mode){
+    return from_cents(multiply_divide(amount.value, percentage.value, 100 * SCALE, mode));
+}
+
+money budget::divide(money amount, long divisor, rounding mode){
+    return from_cents(multiply_divide(amount.value, 1, divisor, mode));
+}
+
 money budget::parse_money(const std::string& money_string){
     size_t dot_pos = money_string.rfind(".");
 
     int dollars = 0;
     int cents = 0;
 
+    auto first = money_string.data();
+    auto last  = money_string.data() + money_string.size();
+
     try {
         if(dot_pos == std::string::npos){
-            dollars = to_number<int>(money_string);
+            dollars = to_number<int>(first, last);
         } else {
-            dollars = to_number<int>(money_string.substr(0, dot_pos));
-
-            auto cents_str = money_string.substr(dot_pos+1, money_string.size() - dot_pos);
-            cents = to_number<int>(cents_str);
+            dollars = to_number<int>(first, first + dot_pos);
+            cents   = to_number<int>(first + dot_pos + 1, last);
         }
-    } catch (std::invalid_argument& e){
-        throw budget::budget_exception("\"" + money_string + "\" is not a valid amount of money");
-    } catch (std::out_of_range& e){
+    } catch (const budget::budget_exception& e){
         throw budget::budget_exception("\"" + money_string + "\" is not a valid amount of money");
     }
 
+    // The sign applies to the cents as well (-0.50 has no negative dollars)
+    auto sign = money_string.find_first_not_of(" \t");
+
+    if (sign != std::string::npos && money_string[sign] == '-') {
+        cents = -cents;
+    }
+
     return {dollars, cents};
 }
 
+bool budget::is_valid_money(const std::string& money_string){
+    auto first = money_string.begin();
+    auto last  = money_string.end();
+
+    if (first != last && (*first == '-' || *first == '+')) {
+        ++first;
+    }
+
+    auto dollars = first;
+
+    while (first != last && std::isdigit(static_cast<unsigned char>(*first))) {
+        ++first;
+    }
+
+    if (first == dollars) {
+        return false;
+    }
+
+    if (first == last) {
+        return true;
+    }
+
+    return last - first == 3 && *first == '.'
+        && std::isdigit(static_cast<unsigned char>(first[1]))
+        && std::isdigit(static_cast<unsigned char>(first[2]));
+}
+
 std::ostream& budget::operator<<(std::ostream& stream, const money& amount){
     if(amount.cents() < 10){
         if(amount.negative()){
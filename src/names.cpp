@@ -0,0 +1,45 @@
+//=======================================================================
+// Copyright (c) 2013-2018 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <cctype>
+#include <cstring>
+
+#include "names.hpp"
+
+using namespace budget;
+
+// Note: The case is compared byte per byte, this is fast, but not very
+// good for locale
+
+bool budget::name_icompare::operator()(const std::string& lhs, const std::string& rhs) const {
+    return strcasecmp(lhs.c_str(), rhs.c_str()) == 0;
+}
+
+// FNV-1a on the lower case characters, without copying the name
+size_t budget::name_icompare::operator()(const std::string& value) const {
+    size_t hash = 14695981039346656037ULL;
+
+    for (unsigned char c : value) {
+        hash ^= std::tolower(c);
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+size_t budget::name_table::id(const std::string& name){
+    auto it = ids.find(name);
+
+    if (it != ids.end()) {
+        return it->second;
+    }
+
+    ids.emplace(name, names.size());
+    names.push_back(name);
+
+    return names.size() - 1;
+}
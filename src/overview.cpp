@@ -6,7 +6,6 @@
 //=======================================================================
 
 #include <cstdio>
-#include <cstring>
 #include <numeric>
 #include <unordered_map>
 #include <unordered_set>
@@ -22,6 +21,7 @@
 #include "budget_exception.hpp"
 #include "config.hpp"
 #include "writer.hpp"
+#include "names.hpp"
 
 using namespace budget;
 
@@ -126,7 +126,19 @@ void add_recap_line(std::vector<std::vector<std::string>>& contents, const std::
 }
 
 std::vector<budget::money> compute_total_budget(budget::month month, budget::year year){
-    std::unordered_map<std::string, budget::money> tmp;
+    // The total of each account, indexed by the id of its name
+    budget::name_table account_names;
+    std::vector<budget::money> tmp;
+
+    auto account_total = [&tmp, &account_names](const budget::account& account) -> budget::money& {
+        auto id = account_names.id(account.name);
+
+        if (id >= tmp.size()) {
+            tmp.resize(id + 1);
+        }
+
+        return tmp[id];
+    };
 
     // By default, the start is the year of the overview
     auto start_year_report = year;
@@ -144,15 +156,12 @@ std::vector<budget::money> compute_total_budget(budget::month month, budget::yea
             }
 
             for(auto& account : all_accounts(y, m)){
-                tmp[account.name] += account.amount;
+                auto& total = account_total(account);
 
-                tmp[account.name] -= accumulate_amount_if(all_expenses(), [y,m,account](budget::expense& e){
-                    return e.account == account.id && e.date.year() == y && e.date.month() == m;
-                    });
+                total += account.amount;
 
-                tmp[account.name] += accumulate_amount_if(all_earnings(), [y,m,account](budget::earning& e){
-                    return e.account == account.id && e.date.year() == y && e.date.month() == m;
-                    });
+                total -= expenses_total(account.id, y, m);
+                total += earnings_total(account.id, y, m);
             }
 
             if(y != year && m == 12){
@@ -166,9 +175,11 @@ std::vector<budget::money> compute_total_budget(budget::month month, budget::yea
     std::vector<budget::money> total_budgets;
 
     for(auto& account : all_accounts(year, month)){
-        tmp[account.name] += account.amount;
+        auto& total = account_total(account);
 
-        total_budgets.push_back(tmp[account.name]);
+        total += account.amount;
+
+        total_budgets.push_back(total);
     }
 
     return total_budgets;
@@ -205,23 +216,54 @@ void add_values_column(budget::month month, budget::year year, const std::string
     add_recap_line(contents, title, total);
 }
 
-struct icompare_str {
-    bool operator()(const std::string& lhs, const std::string& rhs) const {
-        // Note: This is very fast, but not very good for locale
-        return strcasecmp(lhs.c_str(), rhs.c_str()) == 0;
-    }
+// The aggregated expenses of an account
+struct aggregate_column {
+    bool used = false;
+    std::vector<size_t> names;          // The ids of the names, in order of appearance
+    std::vector<budget::money> amounts; // The total of each name, indexed by id
+    std::vector<bool> present;          // Indicates if a name has been added
+
+    void add(size_t name, budget::money amount){
+        if (name >= present.size()) {
+            present.resize(name + 1, false);
+            amounts.resize(name + 1);
+        }
 
-    size_t operator()(const std::string& value) const {
-        auto l_value = value;
-        std::transform(l_value.begin(), l_value.end(), l_value.begin(), ::tolower);
-        std::hash<std::string> hasher;
-        return hasher(l_value);
+        if (!present[name]) {
+            present[name] = true;
+            names.push_back(name);
+        }
+
+        amounts[name] += amount;
     }
 };
 
 template<typename Functor>
 void aggregate_overview(budget::writer& w, bool full, bool disable_groups, const std::string& separator, Functor&& func){
-    std::unordered_map<std::string, std::unordered_map<std::string, budget::money, icompare_str, icompare_str>> acc_expenses;
+    // The names of the accounts and of the expenses of this aggregation
+    budget::name_table account_names;
+    budget::name_table expense_names;
+
+    // The expenses of each account, indexed by the id of the account name
+    std::vector<aggregate_column> acc_expenses;
+    size_t used_columns = 0;
+
+    auto column_of = [&acc_expenses, &used_columns](size_t account) -> aggregate_column& {
+        if (account >= acc_expenses.size()) {
+            acc_expenses.resize(account + 1);
+        }
+
+        auto& column = acc_expenses[account];
+
+        if (!column.used) {
+            column.used = true;
+            ++used_columns;
+        }
+
+        return column;
+    };
+
+    auto all_accounts_id = account_names.id("All accounts");
 
     //Accumulate all the expenses
     for(auto& expense : all_expenses()){
@@ -240,72 +282,71 @@ void aggregate_overview(budget::writer& w, bool full, bool disable_groups, const
             }
 
             if(full){
-                acc_expenses["All accounts"][name] += expense.amount;
+                column_of(all_accounts_id).add(expense_names.id(name), expense.amount);
             } else {
-                auto& account = get_account(expense.account);
-                acc_expenses[account.name][name] += expense.amount;
+                column_of(account_names.id(get_account(expense.account).name)).add(expense_names.id(name), expense.amount);
             }
         }
     }
 
-    std::unordered_map<std::string, budget::money> totals;
+    auto accounts = current_accounts();
+
+    std::vector<budget::money> totals(accounts.size());
     budget::money total;
 
     std::vector<std::string> columns;
     std::vector<std::vector<std::string>> contents;
 
-    for(auto& account : current_accounts()){
-        auto& expenses = acc_expenses[account.name];
+    for(size_t column = 0; column < accounts.size(); ++column){
+        auto& expenses = column_of(account_names.id(accounts[column].name));
 
-        auto column = columns.size();
-        columns.push_back(account.name);
+        columns.push_back(accounts[column].name);
         size_t row = 0;
 
-        typedef std::pair<std::string, budget::money> s_expense;
+        typedef std::pair<size_t, budget::money> s_expense;
         std::vector<s_expense> sorted_expenses;
 
-        for(auto& expense : expenses){
-            sorted_expenses.push_back(std::make_pair(expense.first, expense.second));
+        for(auto name : expenses.names){
+            sorted_expenses.push_back(std::make_pair(name, expenses.amounts[name]));
         }
 
-        std::sort(sorted_expenses.begin(), sorted_expenses.end(),
+        std::stable_sort(sorted_expenses.begin(), sorted_expenses.end(),
             [](const s_expense& a, const s_expense& b){ return a.second > b.second; });
 
         for(auto& expense : sorted_expenses){
             if(contents.size() <= row){
-                contents.emplace_back(acc_expenses.size() * 2, "");
+                contents.emplace_back(used_columns * 2, "");
             }
 
-            contents[row][column * 2] = expense.first;
+            contents[row][column * 2] = expense_names.name(expense.first);
             contents[row][column * 2 + 1] = to_string(expense.second);
 
-            totals[account.name] += expense.second;
+            totals[column] += expense.second;
             total += expense.second;
 
             ++row;
         }
     }
 
-    contents.emplace_back(acc_expenses.size() * 2, "");
-    contents.emplace_back(acc_expenses.size() * 2, "");
+    contents.emplace_back(used_columns * 2, "");
+    contents.emplace_back(used_columns * 2, "");
 
     size_t i = 0;
 
     contents.back()[i++] = "Total";
 
-    for(auto& account : current_accounts()){
-        contents.back()[i++] = to_string(totals[account.name]);
+    for(auto& amount : totals){
+        contents.back()[i++] = to_string(amount);
         i++;
     }
 
-    contents.emplace_back(acc_expenses.size() * 2, "");
+    contents.emplace_back(used_columns * 2, "");
 
     i = 0;
 
     contents.back()[i++] = "Part";
 
-    for(auto& account : current_accounts()){
-        auto& amount = totals[account.name];
+    for(auto& amount : totals){
         float part = 100.0 * (amount.value / float(total.value));
 
         char buffer[32];
@@ -406,6 +447,18 @@ void display_values(budget::writer& w, budget::year year, const std::string& tit
         contents.push_back({account.name});
     }
 
+    // In relaxed mode, the values are matched by the name of their account
+    budget::name_table account_names;
+    std::vector<size_t> value_names;
+
+    if(relaxed){
+        value_names.reserve(values.size());
+
+        for(auto& value : values){
+            value_names.push_back(account_names.id(get_account(value.account).name));
+        }
+    }
+
     //Fill the table
 
     for(unsigned short j = sm; j < 13; ++j){
@@ -414,9 +467,13 @@ void display_values(budget::writer& w, budget::year year, const std::string& tit
         for(auto& account : all_accounts(year, m)){
             budget::money month_total;
 
-            for(auto& value : values){
+            auto account_name = account_names.id(account.name);
+
+            for(size_t v = 0; v < values.size(); ++v){
+                auto& value = values[v];
+
                 if(relaxed){
-                    if(get_account(value.account).name == account.name && value.date.year() == year && value.date.month() == m){
+                    if(value_names[v] == account_name && value.date.year() == year && value.date.month() == m){
                         month_total += value.amount;
                     }
                 } else {
@@ -660,11 +717,11 @@ void budget::display_local_balance(budget::writer& w, budget::year year, bool cu
             budget::money total_earnings;
 
             if(relaxed){
-                total_expenses = accumulate_amount_if(all_expenses(), [account,year,m](budget::expense& e){return get_account(e.account).name == account.name && e.date.year() == year && e.date.month() == m;});
-                total_earnings = accumulate_amount_if(all_earnings(), [account,year,m](budget::earning& e){return get_account(e.account).name == account.name && e.date.year() == year && e.date.month() == m;});
+                total_expenses = expenses_total(account.name, year, m);
+                total_earnings = earnings_total(account.name, year, m);
             } else {
-                total_expenses = accumulate_amount_if(all_expenses(), [account,year,m](budget::expense& e){return e.account == account.id && e.date.year() == year && e.date.month() == m;});
-                total_earnings = accumulate_amount_if(all_earnings(), [account,year,m](budget::earning& e){return e.account == account.id && e.date.year() == year && e.date.month() == m;});
+                total_expenses = expenses_total(account.id, year, m);
+                total_earnings = earnings_total(account.id, year, m);
             }
 
             auto month_total = account.amount - total_expenses + total_earnings;
@@ -842,11 +899,11 @@ void budget::display_balance(budget::writer& w, budget::year year, bool relaxed,
             budget::money total_earnings;
 
             if(relaxed){
-                total_expenses = accumulate_amount_if(all_expenses(), [account,year,m](budget::expense& e){return get_account(e.account).name == account.name && e.date.year() == year && e.date.month() == m;});
-                total_earnings = accumulate_amount_if(all_earnings(), [account,year,m](budget::earning& e){return get_account(e.account).name == account.name && e.date.year() == year && e.date.month() == m;});
+                total_expenses = expenses_total(account.name, year, m);
+                total_earnings = earnings_total(account.name, year, m);
             } else {
-                total_expenses = accumulate_amount_if(all_expenses(), [account,year,m](budget::expense& e){return e.account == account.id && e.date.year() == year && e.date.month() == m;});
-                total_earnings = accumulate_amount_if(all_earnings(), [account,year,m](budget::earning& e){return e.account == account.id && e.date.year() == year && e.date.month() == m;});
+                total_expenses = expenses_total(account.id, year, m);
+                total_earnings = earnings_total(account.id, year, m);
             }
 
             auto month_total = account_previous[account.name][i - 1] + account.amount - total_expenses + total_earnings;
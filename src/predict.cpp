@@ -52,13 +52,13 @@ void predict_overview(){
 
     for(auto& expense : expenses){
         if(account_mappings.count(get_account(expense.account).name)){
-            expense.amount *= (expense_multipliers[account_mappings[get_account(expense.account).name]] / 100.0);
+            expense.amount = multiply(expense.amount, fixed_rate(expense_multipliers[account_mappings[get_account(expense.account).name]] / 100.0));
         }
     }
 
     for(auto& earning : earnings){
         if(account_mappings.count(get_account(earning.account).name)){
-            earning.amount *= (earning_multipliers[account_mappings[get_account(earning.account).name]] / 100.0);
+            earning.amount = multiply(earning.amount, fixed_rate(earning_multipliers[account_mappings[get_account(earning.account).name]] / 100.0));
         }
     }
 
@@ -0,0 +1,249 @@
+//=======================================================================
+// Copyright (c) 2013-2018 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <algorithm>
+#include <functional>
+
+#include "rebalance.hpp"
+#include "assets.hpp"
+#include "currency.hpp"
+
+using namespace budget;
+
+namespace {
+
+budget::money from_cents(long cents){
+    budget::money m;
+    m.value = cents;
+    return m;
+}
+
+// Distribute the remaining money between the assets, proportionally to
+// their desired part. Nothing is distributed without desired parts.
+void distribute(const std::vector<budget::fixed_rate>& desired, std::vector<long>& trades, long remaining){
+    budget::fixed_rate total_desired;
+
+    for (auto& part : desired) {
+        total_desired.value += part.value;
+    }
+
+    if (total_desired.value <= 0) {
+        return;
+    }
+
+    long distributed = 0;
+    size_t largest   = 0;
+
+    for (size_t i = 0; i < desired.size(); ++i) {
+        auto part  = budget::fixed_rate::ratio(desired[i], total_desired, budget::rounding::down);
+        auto extra = budget::multiply(from_cents(remaining), part, budget::rounding::down).value;
+
+        trades[i] += extra;
+        distributed += extra;
+
+        if (desired[i] > desired[largest]) {
+            largest = i;
+        }
+    }
+
+    // The rounding errors go to the largest asset
+    trades[largest] += remaining - distributed;
+}
+
+// Fill the largest gaps first, until the remaining money is exhausted
+void fill_gaps(const std::vector<long>& gaps, std::vector<long>& trades, long remaining){
+    std::vector<long> sorted(gaps);
+    std::sort(sorted.begin(), sorted.end(), std::greater<long>());
+
+    // Find the level such that the parts of the gaps above it sum to the remaining money
+    double level = 0.0;
+    long prefix  = 0;
+
+    for (size_t k = 0; k < sorted.size(); ++k) {
+        prefix += sorted[k];
+
+        double candidate = double(prefix - remaining) / double(k + 1);
+
+        if (k + 1 == sorted.size() || double(sorted[k + 1]) <= candidate) {
+            level = candidate;
+            break;
+        }
+    }
+
+    long distributed = 0;
+
+    for (size_t i = 0; i < gaps.size(); ++i) {
+        trades[i] = std::max(0L, static_cast<long>(gaps[i] - level));
+        distributed += trades[i];
+    }
+
+    // The rounding errors are spread over the assets that are traded
+    for (size_t i = 0; i < gaps.size() && distributed < remaining; ++i) {
+        if (trades[i] > 0) {
+            ++trades[i];
+            ++distributed;
+        }
+    }
+}
+
+// Never sell more than the holdings of an asset, the excess is sold from
+// the other assets
+void limit_sells(const std::vector<long>& holdings, std::vector<long>& trades){
+    long excess = 0;
+
+    for (size_t i = 0; i < trades.size(); ++i) {
+        if (trades[i] > holdings[i]) {
+            excess += trades[i] - holdings[i];
+            trades[i] = holdings[i];
+        }
+    }
+
+    for (size_t i = 0; i < trades.size() && excess > 0; ++i) {
+        auto extra = std::min(excess, holdings[i] - trades[i]);
+
+        trades[i] += extra;
+        excess -= extra;
+    }
+}
+
+} // end of anonymous namespace
+
+std::vector<double> budget::portfolio_allocation::allocation() const {
+    std::vector<double> allocation(size());
+
+    for (size_t i = 0; i < size(); ++i) {
+        allocation[i] = 100.0 * (values[i] / total);
+    }
+
+    return allocation;
+}
+
+std::array<budget::money, 4> budget::portfolio_allocation::class_values() const {
+    std::array<budget::money, 4> classes;
+
+    for (size_t i = 0; i < size(); ++i) {
+        classes[0] += multiply(values[i], int_stocks[i]);
+        classes[1] += multiply(values[i], dom_stocks[i]);
+        classes[2] += multiply(values[i], bonds[i]);
+        classes[3] += multiply(values[i], cash[i]);
+    }
+
+    return classes;
+}
+
+budget::portfolio_allocation budget::current_portfolio_allocation(){
+    portfolio_allocation portfolio;
+
+    auto currency = get_default_currency();
+
+    for (auto& asset : all_assets()) {
+        if (!asset.portfolio) {
+            continue;
+        }
+
+        budget::money amount;
+
+        auto value = find_last_asset_value(asset.id);
+
+        if (value.first) {
+            amount = get_asset_value(value.second).amount;
+        }
+
+        if (amount.zero() && asset.portfolio_alloc.zero()) {
+            continue;
+        }
+
+        portfolio.ids.push_back(asset.id);
+        portfolio.amounts.push_back(amount);
+        portfolio.values.push_back(convert(amount, asset.currency, currency));
+        portfolio.desired.push_back(fixed_rate::percent(asset.portfolio_alloc));
+
+        portfolio.int_stocks.push_back(fixed_rate::percent(asset.int_stocks));
+        portfolio.dom_stocks.push_back(fixed_rate::percent(asset.dom_stocks));
+        portfolio.bonds.push_back(fixed_rate::percent(asset.bonds));
+        portfolio.cash.push_back(fixed_rate::percent(asset.cash));
+
+        portfolio.total += portfolio.values.back();
+    }
+
+    return portfolio;
+}
+
+budget::rebalance_plan budget::full_rebalance(const portfolio_allocation& portfolio, budget::money new_money){
+    rebalance_plan plan;
+
+    plan.targets.resize(portfolio.size());
+    plan.trades.resize(portfolio.size());
+
+    // It is not possible to withdraw more than the portfolio
+    auto total = std::max(budget::money(), portfolio.total + new_money);
+
+    for (size_t i = 0; i < portfolio.size(); ++i) {
+        plan.targets[i] = multiply(total, portfolio.desired[i]);
+        plan.trades[i]  = plan.targets[i] - portfolio.values[i];
+
+        plan.effort += plan.trades[i].abs();
+    }
+
+    return plan;
+}
+
+budget::rebalance_plan budget::minimal_rebalance(const portfolio_allocation& portfolio, budget::money new_money){
+    auto plan = full_rebalance(portfolio, new_money);
+
+    bool buy       = !new_money.negative();
+    long remaining = buy ? new_money.value : -new_money.value;
+
+    // What can be sold of each asset
+    std::vector<long> holdings(portfolio.size());
+
+    long total_holdings = 0;
+
+    for (size_t i = 0; i < portfolio.size(); ++i) {
+        holdings[i] = std::max(0L, portfolio.values[i].value);
+        total_holdings += holdings[i];
+    }
+
+    // It is not possible to withdraw more than the portfolio
+    if (!buy) {
+        remaining = std::min(remaining, total_holdings);
+    }
+
+    // The distance of each asset to its target, in the direction of the trades
+    std::vector<long> gaps(portfolio.size());
+
+    long total_gap = 0;
+
+    for (size_t i = 0; i < portfolio.size(); ++i) {
+        auto gap = plan.targets[i].value - portfolio.values[i].value;
+
+        gaps[i] = buy ? std::max(0L, gap) : std::min(std::max(0L, -gap), holdings[i]);
+        total_gap += gaps[i];
+    }
+
+    std::vector<long> trades(portfolio.size(), 0);
+
+    if (total_gap <= remaining) {
+        trades = gaps;
+        distribute(portfolio.desired, trades, remaining - total_gap);
+    } else {
+        fill_gaps(gaps, trades, remaining);
+    }
+
+    if (!buy) {
+        limit_sells(holdings, trades);
+    }
+
+    plan.effort = budget::money();
+
+    for (size_t i = 0; i < portfolio.size(); ++i) {
+        plan.trades[i] = from_cents(buy ? trades[i] : -trades[i]);
+        plan.effort += plan.trades[i].abs();
+    }
+
+    return plan;
+}
@@ -103,10 +103,8 @@ void budget::report(budget::writer& w, budget::year year, bool filter, const std
 
              for (auto& account : all_accounts(year, month)) {
                  if (!filter || account.name == filter_account) {
-                     auto expenses = accumulate_amount_if(all_expenses(),
-                                                          [year, month, account](budget::expense& e) { return e.account == account.id && e.date.year() == year && e.date.month() == month; });
-                     auto earnings = accumulate_amount_if(all_earnings(),
-                                                          [year, month, account](budget::earning& e) { return e.account == account.id && e.date.year() == year && e.date.month() == month; });
+                     auto expenses = expenses_total(account.id, year, month);
+                     auto earnings = earnings_total(account.id, year, month);
 
                      m_expenses += expenses;
                      m_earnings += earnings;
@@ -149,10 +147,8 @@ void budget::report(budget::writer& w, budget::year year, bool filter, const std
 
         for (auto& account : all_accounts(year, month)) {
             if (!filter || account.name == filter_account) {
-                auto expenses = accumulate_amount_if(all_expenses(),
-                                                     [year, month, account](budget::expense& e) { return e.account == account.id && e.date.year() == year && e.date.month() == month; });
-                auto earnings = accumulate_amount_if(all_earnings(),
-                                                     [year, month, account](budget::earning& e) { return e.account == account.id && e.date.year() == year && e.date.month() == month; });
+                auto expenses = expenses_total(account.id, year, month);
+                auto earnings = earnings_total(account.id, year, month);
 
                 total_expenses += expenses;
                 total_earnings += earnings;
@@ -6,6 +6,10 @@
 //=======================================================================
 
 #include <iostream>
+#include <fstream>
+#include <random>
+#include <thread>
+#include <algorithm>
 
 #include "retirement.hpp"
 #include "assets.hpp"
@@ -16,6 +20,8 @@
 #include "config.hpp"
 #include "console.hpp"
 #include "writer.hpp"
+#include "currency.hpp"
+#include "compute.hpp"
 
 using namespace budget;
 
@@ -23,80 +29,115 @@ namespace {
 
 constexpr size_t running_limit = 12;
 
-money running_expenses(budget::date d = budget::local_day()){
+// The history of the running_limit months before the month of the given date
+budget::monthly_history running_history(budget::date d){
     budget::date end = d - budget::days(d.day() - 1);
-    budget::date start = end - budget::months(running_limit);
 
-    budget::money total;
+    return compute_monthly_history(end - budget::months(running_limit), end - budget::months(1));
+}
 
-    for(auto& expense : all_expenses()){
-        if(expense.date >= start && expense.date < end){
-            total += expense.amount;
-        }
-    }
+money running_expenses(budget::date d = budget::local_day()){
+    auto history = running_history(d);
+    return history.total_expenses(0, history.size());
+}
 
-    return total;
+double running_savings_rate(budget::date d = budget::local_day()){
+    auto history = running_history(d);
+    return history.average_savings_rate(0, history.size());
 }
 
-double running_savings_rate(budget::date sd = budget::local_day()){
-    double savings_rate = 0.0;
+void retirement_set() {
+    double wrate = 4.0;
+    double roi = 4.0;
 
-    for(size_t i = 1; i <= running_limit; ++i){
-        auto d = sd - budget::months(i);
+    if(internal_config_contains("withdrawal_rate")){
+        wrate = to_number<double>(internal_config_value("withdrawal_rate"));
+    }
 
-        budget::money expenses;
+    if(internal_config_contains("expected_roi")){
+        roi = to_number<double>(internal_config_value("expected_roi"));
+    }
 
-        for (auto& expense : all_expenses()) {
-            if (expense.date.year() == d.year() && expense.date.month() == d.month()) {
-                expenses += expense.amount;
-            }
-        }
+    edit_double(wrate, "Withdrawal Rate (%)");
+    edit_double(roi, "Expected Annual Return (%)");
 
-        budget::money earnings;
+    // Save the configuration
+    internal_config_value("withdrawal_rate") = to_string(wrate);
+    internal_config_value("expected_roi") = to_string(roi);
+}
 
-        for (auto& earning : all_earnings()) {
-            if (earning.date.year() == d.year() && earning.date.month() == d.month()) {
-                earnings += earning.amount;
-            }
-        }
+// The default mean and standard deviation of the real yearly returns of
+// international stocks, domestic stocks, bonds and cash (in percent)
+constexpr const double default_means[4]      = {5.0, 5.0, 1.5, 0.0};
+constexpr const double default_deviations[4] = {17.0, 17.0, 6.0, 1.0};
+
+// The part of each class in the net worth
+std::array<double, 4> class_weights(){
+    std::array<double, 4> weights{{0.0, 0.0, 0.0, 0.0}};
+    double total = 0.0;
 
-        budget::money income;
+    for (auto& asset : all_assets()) {
+        auto value = find_last_asset_value(asset.id);
 
-        for (auto& account : all_accounts(d.year(), d.month())){
-            income += account.amount;
+        if (asset.name == "DESIRED" || !value.first) {
+            continue;
         }
 
-        auto balance = income + earnings - expenses;
-        auto local   = balance / (income + earnings);
+        double amount = get_asset_value(value.second).amount * exchange_rate(asset.currency);
 
-        if(local < 0){
-            local = 0;
-        }
+        weights[0] += amount * (float(asset.int_stocks) / 100.0);
+        weights[1] += amount * (float(asset.dom_stocks) / 100.0);
+        weights[2] += amount * (float(asset.bonds) / 100.0);
+        weights[3] += amount * (float(asset.cash) / 100.0);
+
+        total += amount;
+    }
+
+    // Without assets, the net worth is considered as cash
+    if (total <= 0.0) {
+        return {{0.0, 0.0, 0.0, 1.0}};
+    }
 
-        savings_rate += local;
+    for (auto& weight : weights) {
+        weight /= total;
     }
 
-    return savings_rate / running_limit;
+    return weights;
 }
 
-void retirement_set() {
-    double wrate = 4.0;
-    double roi = 4.0;
+// The historical yearly returns of each class, in lines year:int_stocks:dom_stocks:bonds:cash
+std::vector<std::array<double, 4>> historical_returns(){
+    std::vector<std::array<double, 4>> history;
 
-    if(internal_config_contains("withdrawal_rate")){
-        wrate = to_number<double>(internal_config_value("withdrawal_rate"));
+    if (!config_contains("retirement_returns_file")) {
+        return history;
     }
 
-    if(internal_config_contains("expected_roi")){
-        roi = to_number<double>(internal_config_value("expected_roi"));
+    std::ifstream file(config_value("retirement_returns_file"));
+    std::string line;
+
+    while (std::getline(file, line)) {
+        auto parts = split(line, ':');
+
+        if (parts.size() == 5) {
+            std::array<double, 4> returns;
+
+            for (size_t c = 0; c < 4; ++c) {
+                returns[c] = to_number<double>(parts[c + 1]) / 100.0;
+            }
+
+            history.push_back(returns);
+        }
     }
 
-    edit_double(wrate, "Withdrawal Rate (%)");
-    edit_double(roi, "Expected Annual Return (%)");
+    return history;
+}
 
-    // Save the configuration
-    internal_config_value("withdrawal_rate") = to_string(wrate);
-    internal_config_value("expected_roi") = to_string(roi);
+// Note: values is reordered
+double percentile(std::vector<double>& values, double p){
+    auto k = std::min(values.size() - 1, size_t(p * (values.size() - 1) + 0.5));
+    std::nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
 }
 
 } // end of anonymous namespace
@@ -118,6 +159,21 @@ void budget::retirement_module::handle(std::vector<std::string>& args) {
 
         if (subcommand == "status") {
             retirement_status(w);
+        } else if (subcommand == "simulate") {
+            if (!internal_config_contains("withdrawal_rate")) {
+                w << "Not enough information, please configure first with retirement set" << end_of_line;
+                return;
+            }
+
+            size_t simulations = 10000;
+
+            if (args.size() > 2) {
+                simulations = to_number<size_t>(args[2]);
+            } else if (config_contains("retirement_simulations")) {
+                simulations = to_number<size_t>(config_value("retirement_simulations"));
+            }
+
+            retirement_simulate(w, simulate_retirement(simulations));
         } else if (subcommand == "set") {
             retirement_set();
             std::cout << std::endl;
@@ -129,10 +185,13 @@ void budget::retirement_module::handle(std::vector<std::string>& args) {
 }
 
 float budget::fi_ratio(budget::date d) {
+    return fi_ratio(d, get_net_worth(d));
+}
+
+float budget::fi_ratio(budget::date d, budget::money nw) {
     auto wrate          = to_number<double>(internal_config_value("withdrawal_rate"));
     auto years          = double(int(100.0 / wrate));
     auto expenses       = running_expenses(d);
-    auto nw             = get_net_worth(d);
     auto missing        = years * expenses - nw;
 
     return nw / missing;
@@ -269,3 +328,189 @@ void budget::retirement_status(budget::writer& w) {
         w << p_begin << "Decreasing monthly expenses by " << dec << " " << currency << " would save " << (base_months - months) / 12.0 << " years (in " << months / 12.0 << " (adjusted) years)" << p_end;
     }
 }
+
+budget::retirement_simulation budget::simulate_retirement(size_t simulations) {
+    retirement_simulation simulation;
+
+    simulation.simulations = std::max(simulations, size_t(1));
+    simulation.years       = 30;
+
+    if (config_contains("retirement_years")) {
+        simulation.years = to_number<size_t>(config_value("retirement_years"));
+    }
+
+    // The memory and the time grow with both
+    if (simulation.simulations > max_retirement_simulations) {
+        throw budget_exception("The number of simulations cannot be more than " + to_string(max_retirement_simulations));
+    }
+
+    if (simulation.years > max_retirement_years) {
+        throw budget_exception("The number of simulated years cannot be more than " + to_string(max_retirement_years));
+    }
+
+    // All the data is read before starting the threads
+
+    auto wrate    = to_number<double>(internal_config_value("withdrawal_rate"));
+    auto years    = double(int(100.0 / wrate));
+    auto expenses = double(running_expenses());
+    auto nw       = double(get_net_worth());
+    auto income   = double(12 * get_base_income());
+    auto savings  = running_savings_rate() * income;
+    auto target   = years * expenses;
+
+    auto weights = class_weights();
+    auto history = historical_returns();
+
+    const size_t n = simulation.simulations;
+    const size_t h = simulation.years;
+
+    std::vector<double> paths(n * (h + 1)); // The net worth of each simulation each year, when retiring now
+    std::vector<double> fi_years(n);        // The years to FI of each simulation (h + 1 if never)
+
+    auto run = [&](size_t first, size_t step, std::mt19937_64 generator) {
+        std::array<std::normal_distribution<double>, 4> distributions;
+
+        for (size_t c = 0; c < 4; ++c) {
+            distributions[c] = std::normal_distribution<double>(default_means[c] / 100.0, default_deviations[c] / 100.0);
+        }
+
+        std::uniform_int_distribution<size_t> history_distribution(0, history.empty() ? 0 : history.size() - 1);
+
+        for (size_t s = first; s < n; s += step) {
+            auto* path = &paths[s * (h + 1)];
+
+            double retired     = nw;
+            double accumulated = nw;
+
+            path[0]     = retired;
+            fi_years[s] = accumulated >= target ? 0 : h + 1;
+
+            for (size_t y = 0; y < h; ++y) {
+                double r = 0.0;
+
+                if (history.empty()) {
+                    for (size_t c = 0; c < 4; ++c) {
+                        r += weights[c] * distributions[c](generator);
+                    }
+                } else {
+                    auto& returns = history[history_distribution(generator)];
+
+                    for (size_t c = 0; c < 4; ++c) {
+                        r += weights[c] * returns[c];
+                    }
+                }
+
+                retired     = std::max(0.0, retired * (1.0 + r) - expenses);
+                accumulated = accumulated * (1.0 + r) + savings;
+
+                path[y + 1] = retired;
+
+                if (fi_years[s] > h && accumulated >= target) {
+                    fi_years[s] = y + 1;
+                }
+            }
+        }
+    };
+
+    // Each thread has its own generator, seeded differently
+
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::random_device seeder;
+
+    std::vector<std::thread> workers;
+
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back(run, t, threads, std::mt19937_64(seeder()));
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // Compute the statistics
+
+    size_t successes = 0;
+    size_t reached   = 0;
+
+    for (size_t s = 0; s < n; ++s) {
+        if (paths[s * (h + 1) + h] > 0.0) {
+            ++successes;
+        }
+
+        if (fi_years[s] <= h) {
+            ++reached;
+        }
+    }
+
+    simulation.success        = successes / double(n);
+    simulation.fi_probability = reached / double(n);
+
+    simulation.fi_years[0] = percentile(fi_years, 0.1);
+    simulation.fi_years[1] = percentile(fi_years, 0.5);
+    simulation.fi_years[2] = percentile(fi_years, 0.9);
+
+    std::array<double, 5> levels{{0.1, 0.25, 0.5, 0.75, 0.9}};
+    std::vector<double> values(n);
+
+    for (size_t y = 0; y <= h; ++y) {
+        for (size_t s = 0; s < n; ++s) {
+            values[s] = paths[s * (h + 1) + y];
+        }
+
+        std::array<budget::money, 5> band;
+
+        for (size_t l = 0; l < levels.size(); ++l) {
+            band[l] = budget::money(1) * percentile(values, levels[l]);
+        }
+
+        simulation.bands.push_back(band);
+    }
+
+    return simulation;
+}
+
+void budget::retirement_simulate(budget::writer& w, const retirement_simulation& simulation) {
+    auto currency = get_default_currency();
+
+    auto fi_years = [&simulation](double years) {
+        return years > simulation.years ? std::string("Never") : to_string_precision(years, 0);
+    };
+
+    std::vector<std::string> columns = {};
+    std::vector<std::vector<std::string>> contents;
+
+    using namespace std::string_literals;
+
+    contents.push_back({"Simulations"s, to_string(simulation.simulations)});
+    contents.push_back({"Years"s, to_string(simulation.years)});
+
+    contents.push_back({""s, ""s});
+    contents.push_back({"Success when retiring now"s, to_string_precision(100.0 * simulation.success, 2) + "%"});
+    contents.push_back({"Probability to reach FI"s, to_string_precision(100.0 * simulation.fi_probability, 2) + "%"});
+
+    contents.push_back({""s, ""s});
+    contents.push_back({"Years to FI (10th percentile)"s, fi_years(simulation.fi_years[0])});
+    contents.push_back({"Years to FI (median)"s, fi_years(simulation.fi_years[1])});
+    contents.push_back({"Years to FI (90th percentile)"s, fi_years(simulation.fi_years[2])});
+
+    w.display_table(columns, contents);
+
+    w << title_begin << "Net Worth when retiring now" << title_end;
+
+    std::vector<std::string> band_columns = {"Year", "10%", "25%", "Median", "75%", "90%"};
+    std::vector<std::vector<std::string>> band_contents;
+
+    for (size_t y = 0; y < simulation.bands.size(); ++y) {
+        if (y % 5 == 0 || y + 1 == simulation.bands.size()) {
+            auto& band = simulation.bands[y];
+
+            band_contents.push_back({to_string(y)});
+
+            for (auto& value : band) {
+                band_contents.back().push_back(to_string(value) + " " + currency);
+            }
+        }
+    }
+
+    w.display_table(band_columns, band_contents);
+}
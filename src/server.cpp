@@ -7,10 +7,15 @@
 
 #include <set>
 #include <thread>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
 
 #include "cpp_utils/assert.hpp"
 
 #include "server.hpp"
+#include "data.hpp"
 #include "expenses.hpp"
 #include "earnings.hpp"
 #include "accounts.hpp"
@@ -32,6 +37,14 @@ namespace {
 
 bool server_running = false;
 
+std::shared_timed_mutex data_lock;
+
+std::atomic<bool> stop_requested(false);
+
+void stop_handler(int /*signal*/){
+    stop_requested = true;
+}
+
 void start_server(){
     httplib::Server server;
 
@@ -56,19 +69,84 @@ void start_server(){
 void start_cron_loop(){
     size_t hours = 0;
 
+    // The exchange rates are obtained in the background, so that the pages
+    // do not have to wait for them
+    budget::fetch_asset_exchange_rates();
+
     while(true){
         using namespace std::chrono_literals;
 
         std::this_thread::sleep_for(1h);
         ++hours;
 
-        check_for_recurrings();
+        {
+            std::unique_lock<std::shared_timed_mutex> lock(data_lock);
+            check_for_recurrings();
+        }
 
         if(hours % 6 == 0){
             std::cout << "Invalidate the currency cache" << std::endl;
             budget::invalidate_currency_cache();
         }
+
+        // New assets or new months may need more rates
+        budget::fetch_asset_exchange_rates();
+    }
+}
+
+void save_all(){
+    save_accounts();
+    save_expenses();
+    save_earnings();
+    save_assets();
+    save_objectives();
+    save_wishes();
+    save_fortunes();
+    save_recurrings();
+    save_debts();
+}
+
+/*!
+ * \brief Write-behind of the data of the server.
+ *
+ * The handlers only mark the modules as changed, the modified modules
+ * are saved at regular interval and before exiting.
+ */
+void start_flush_loop(){
+    using namespace std::chrono_literals;
+
+    std::chrono::seconds interval(1);
+
+    if(config_contains("server_flush_interval")){
+        interval = std::chrono::seconds(to_number<size_t>(config_value("server_flush_interval")));
+    }
+
+    auto last_flush = std::chrono::steady_clock::now();
+
+    while(!stop_requested){
+        std::this_thread::sleep_for(100ms);
+
+        if(std::chrono::steady_clock::now() - last_flush >= interval){
+            {
+                // Saving only reads the data
+                std::shared_lock<std::shared_timed_mutex> lock(data_lock);
+                save_all();
+            }
+
+            last_flush = std::chrono::steady_clock::now();
+        }
     }
+
+    std::cout << "Saving the data before exiting" << std::endl;
+
+    // No more modifications are possible after this point
+    data_lock.lock();
+
+    save_all();
+
+    // The server thread cannot be interrupted
+    std::cout.flush();
+    std::quick_exit(0);
 }
 
 } //end of anonymous namespace
@@ -96,13 +174,32 @@ void budget::server_module::handle(const std::vector<std::string>& args){
 
     std::cout << "Starting the server" << std::endl;
 
+    std::signal(SIGINT, stop_handler);
+    std::signal(SIGTERM, stop_handler);
+
     std::thread server_thread([](){ start_server(); });
     std::thread cron_thread([](){ start_cron_loop(); });
+    std::thread flush_thread([](){ start_flush_loop(); });
 
     server_thread.join();
     cron_thread.join();
+    flush_thread.join();
 }
 
 bool budget::is_server_running(){
     return server_running;
 }
+
+std::shared_timed_mutex& budget::server_data_lock(){
+    return data_lock;
+}
+
+void budget::run_read_only(const std::function<void()>& function){
+    std::shared_lock<std::shared_timed_mutex> lock(data_lock);
+
+    pinned_data pinned;
+
+    lock.unlock();
+
+    function();
+}
@@ -11,7 +11,10 @@
 
 #include "accounts.hpp"
 #include "assets.hpp"
+#include "budget_exception.hpp"
+#include "compress.hpp"
 #include "config.hpp"
+#include "data.hpp"
 #include "debts.hpp"
 #include "expenses.hpp"
 #include "fortune.hpp"
@@ -22,6 +25,7 @@
 #include "version.hpp"
 #include "wishes.hpp"
 #include "writer.hpp"
+#include "server.hpp"
 #include "server_api.hpp"
 #include "http.hpp"
 
@@ -100,6 +104,54 @@ void api_success_content(const httplib::Request& /*req*/, httplib::Response& res
     res.set_content(content, "text/plain");
 }
 
+void api_success_content(const httplib::Request& /*req*/, httplib::Response& res, std::string&& content) {
+    // The content can be large, it is moved instead of copied
+    res.body = std::move(content);
+    res.set_header("Content-Type", "text/plain");
+}
+
+// Writes directly into a string, without the copy made by std::stringstream
+struct string_buffer : std::streambuf {
+    explicit string_buffer(std::string& out) : out(out) {
+        // Nothing else to init
+    }
+
+    int_type overflow(int_type c) override {
+        if (c != traits_type::eof()) {
+            out.push_back(traits_type::to_char_type(c));
+        }
+
+        return c;
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        out.append(s, n);
+        return n;
+    }
+
+private:
+    std::string& out;
+};
+
+// Note: The whole list is still built in memory before being sent. The
+// version of cpp-httplib in use cannot send chunked responses, so the rows
+// cannot be streamed to the client.
+template<typename T>
+void api_list(const httplib::Request& req, httplib::Response& res, std::vector<T>& entries) {
+    std::string content;
+
+    {
+        string_buffer buffer(content);
+        std::ostream out(&buffer);
+
+        for (auto& entry : entries) {
+            out << entry << '\n';
+        }
+    }
+
+    api_success_content(req, res, std::move(content));
+}
+
 void api_error(const httplib::Request& req, httplib::Response& res, const std::string& message) {
     if (req.has_param("server")) {
         auto url = req.get_param_value("back_page") + "?error=true&message=" + httplib::detail::encode_url(message);
@@ -229,14 +281,7 @@ void list_accounts_api(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
-    std::stringstream ss;
-
-    for (auto& account : all_accounts()) {
-        ss << account;
-        ss << std::endl;
-    }
-
-    api_success_content(req, res, ss.str());
+    api_list(req, res, all_accounts());
 }
 
 void archive_accounts_month_api(const httplib::Request& req, httplib::Response& res) {
@@ -304,7 +349,7 @@ void edit_expenses_api(const httplib::Request& req, httplib::Response& res) {
     expense.name     = req.get_param_value("input_name");
     expense.amount   = budget::parse_money(req.get_param_value("input_amount"));
 
-    set_expenses_changed();
+    edit_expense(expense);
 
     api_success(req, res, "Expense " + to_string(expense.id) + " has been modified");
 }
@@ -336,14 +381,7 @@ void list_expenses_api(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
-    std::stringstream ss;
-
-    for (auto& expense : all_expenses()) {
-        ss << expense;
-        ss << std::endl;
-    }
-
-    api_success_content(req, res, ss.str());
+    api_list(req, res, all_expenses());
 }
 
 void add_earnings_api(const httplib::Request& req, httplib::Response& res) {
@@ -391,7 +429,7 @@ void edit_earnings_api(const httplib::Request& req, httplib::Response& res) {
     earning.name     = req.get_param_value("input_name");
     earning.amount   = budget::parse_money(req.get_param_value("input_amount"));
 
-    set_earnings_changed();
+    edit_earning(earning);
 
     api_success(req, res, "Earning " + to_string(earning.id) + " has been modified");
 }
@@ -423,14 +461,7 @@ void list_earnings_api(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
-    std::stringstream ss;
-
-    for (auto& earning : all_earnings()) {
-        ss << earning;
-        ss << std::endl;
-    }
-
-    api_success_content(req, res, ss.str());
+    api_list(req, res, all_earnings());
 }
 
 void retirement_configure_api(const httplib::Request& req, httplib::Response& res) {
@@ -532,14 +563,7 @@ void list_objectives_api(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
-    std::stringstream ss;
-
-    for (auto& objective : all_objectives()) {
-        ss << objective;
-        ss << std::endl;
-    }
-
-    api_success_content(req, res, ss.str());
+    api_list(req, res, all_objectives());
 }
 
 void add_assets_api(const httplib::Request& req, httplib::Response& res) {
@@ -637,14 +661,7 @@ void list_assets_api(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
-    std::stringstream ss;
-
-    for (auto& asset : all_assets()) {
-        ss << asset;
-        ss << std::endl;
-    }
-
-    api_success_content(req, res, ss.str());
+    api_list(req, res, all_assets());
 }
 
 void add_asset_values_api(const httplib::Request& req, httplib::Response& res) {
@@ -722,14 +739,7 @@ void list_asset_values_api(const httplib::Request& req, httplib::Response& res)
         return;
     }
 
-    std::stringstream ss;
-
-    for (auto& asset_value : all_asset_values()) {
-        ss << asset_value;
-        ss << std::endl;
-    }
-
-    api_success_content(req, res, ss.str());
+    api_list(req, res, all_asset_values());
 }
 
 void batch_asset_values_api(const httplib::Request& req, httplib::Response& res) {
@@ -737,7 +747,21 @@ void batch_asset_values_api(const httplib::Request& req, httplib::Response& res)
         return;
     }
 
-    auto sorted_asset_values = all_sorted_asset_values();
+    if (!req.has_param("input_date")) {
+        api_error(req, res, "Invalid parameters");
+        return;
+    }
+
+    budget::date set_date;
+
+    try {
+        set_date = budget::from_string(req.get_param_value("input_date"));
+    } catch (const budget::date_exception& e) {
+        api_error(req, res, "Invalid date: " + e.message());
+        return;
+    }
+
+    std::vector<asset_value> new_values;
 
     for (auto& asset : all_assets()) {
         auto input_name = "input_amount_" + budget::to_string(asset.id);
@@ -747,10 +771,10 @@ void batch_asset_values_api(const httplib::Request& req, httplib::Response& res)
 
             budget::money current_amount;
 
-            for (auto& asset_value : sorted_asset_values) {
-                if (asset_value.asset_id == asset.id) {
-                    current_amount = asset_value.amount;
-                }
+            auto current = find_last_asset_value(asset.id);
+
+            if (current.first) {
+                current_amount = get_asset_value(current.second).amount;
             }
 
             // If the amount changed, update it
@@ -759,13 +783,16 @@ void batch_asset_values_api(const httplib::Request& req, httplib::Response& res)
                 asset_value.guid     = budget::generate_guid();
                 asset_value.amount   = new_amount;
                 asset_value.asset_id = asset.id;
-                asset_value.set_date = budget::from_string(req.get_param_value("input_date"));
+                asset_value.set_date = set_date;
 
-                add_asset_value(std::move(asset_value));
+                new_values.push_back(std::move(asset_value));
             }
         }
     }
 
+    // All the values are saved at once
+    add_asset_values(std::move(new_values));
+
     api_success(req, res, "Asset values have been updated");
 }
 
@@ -845,14 +872,7 @@ void list_recurrings_api(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
-    std::stringstream ss;
-
-    for (auto& recurring : all_recurrings()) {
-        ss << recurring;
-        ss << std::endl;
-    }
-
-    api_success_content(req, res, ss.str());
+    api_list(req, res, all_recurrings());
 }
 
 void add_debts_api(const httplib::Request& req, httplib::Response& res) {
@@ -935,14 +955,7 @@ void list_debts_api(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
-    std::stringstream ss;
-
-    for (auto& debt : all_debts()) {
-        ss << debt;
-        ss << std::endl;
-    }
-
-    api_success_content(req, res, ss.str());
+    api_list(req, res, all_debts());
 }
 
 void add_fortunes_api(const httplib::Request& req, httplib::Response& res) {
@@ -1018,14 +1031,7 @@ void list_fortunes_api(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
-    std::stringstream ss;
-
-    for (auto& fortune : all_fortunes()) {
-        ss << fortune;
-        ss << std::endl;
-    }
-
-    api_success_content(req, res, ss.str());
+    api_list(req, res, all_fortunes());
 }
 
 void add_wishes_api(const httplib::Request& req, httplib::Response& res) {
@@ -1115,75 +1121,273 @@ void list_wishes_api(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
-    std::stringstream ss;
+    api_list(req, res, all_wishes());
+}
+
+template<typename T>
+void add_sync_module(std::ostream& out, const char* module, std::vector<T>& entries) {
+    out << '#' << module << ':' << entries.size() << ':' << data_epoch() << ':' << module_version(module) << '\n';
+
+    for (auto& entry : entries) {
+        out << entry << '\n';
+    }
+}
+
+void sync_api(const httplib::Request& req, httplib::Response& res) {
+    if (!api_start(req, res)) {
+        return;
+    }
+
+    // Each module starts with a #module:rows:epoch:version line, the rows
+    // themselves always start with their id
+    std::string content;
+
+    string_buffer buffer(content);
+    std::ostream out(&buffer);
+
+    add_sync_module(out, "accounts", all_accounts());
+    add_sync_module(out, "expenses", all_expenses());
+    add_sync_module(out, "earnings", all_earnings());
+    add_sync_module(out, "recurrings", all_recurrings());
+    add_sync_module(out, "debts", all_debts());
+    add_sync_module(out, "fortunes", all_fortunes());
+    add_sync_module(out, "wishes", all_wishes());
+    add_sync_module(out, "assets", all_assets());
+    add_sync_module(out, "asset_values", all_asset_values());
+    add_sync_module(out, "objectives", all_objectives());
+
+    // The rows compress very well, they are compressed when the client
+    // supports it
+    std::string compressed;
+
+    if (req.get_header_value("Accept-Encoding").find("gzip") != std::string::npos && gzip_compress(content, compressed)) {
+        api_success_content(req, res, std::move(compressed));
+        res.set_header("Content-Encoding", "gzip");
+        return;
+    }
+
+    api_success_content(req, res, std::move(content));
+}
+
+void module_changes_api(const httplib::Request& req, httplib::Response& res) {
+    if (!api_start(req, res)) {
+        return;
+    }
+
+    std::string module = req.matches[1];
+
+    size_t since = 0;
+
+    // The versions of another epoch cannot be compared, everything is sent
+    if (req.has_param("since") && req.has_param("epoch") && req.get_param_value("epoch") == data_epoch()) {
+        try {
+            since = budget::to_number<size_t>(req.get_param_value("since"));
+        } catch (const budget::budget_exception& e) {
+            api_error(req, res, "Invalid parameters");
+            return;
+        }
+    }
+
+    std::string content;
+
+    string_buffer buffer(content);
+    std::ostream out(&buffer);
+
+    out << data_epoch() << ':';
+
+    if (!write_module_changes(module, out, since)) {
+        api_error(req, res, "The module " + module + " does not exist");
+        return;
+    }
+
+    api_success_content(req, res, std::move(content));
+}
+
+// The rows of a batch are in the input_rows parameter or directly in the
+// body, one per line, in the format of the data files. The ids and the
+// guids of the rows are ignored.
+std::string batch_rows(const httplib::Request& req) {
+    if (req.has_param("input_rows")) {
+        return req.get_param_value("input_rows");
+    }
+
+    if (req.get_header_value("Content-Type").find("application/x-www-form-urlencoded") == std::string::npos) {
+        return req.body;
+    }
+
+    return "";
+}
+
+/*!
+ * \brief Parse and validate all the rows of an expense or earning batch,
+ * nothing is added if one of them is invalid.
+ */
+template<typename T>
+bool parse_account_batch(const httplib::Request& req, httplib::Response& res, std::vector<T>& entries) {
+    auto rows = batch_rows(req);
+
+    std::string error;
+    size_t row = 0;
+
+    data_handler<T>::for_each_line(rows.data(), rows.data() + rows.size(), [&](std::vector<std::string>& parts) {
+        ++row;
+
+        if (!error.empty()) {
+            return;
+        }
+
+        if (parts.size() < 6) {
+            error = "Invalid row " + to_string(row);
+            return;
+        }
+
+        if (!is_valid_money(parts[4])) {
+            error = "Invalid amount in row " + to_string(row) + ": " + parts[4];
+            return;
+        }
+
+        T entry;
+
+        try {
+            parts >> entry;
+        } catch (const budget::date_exception& e) {
+            error = "Invalid date in row " + to_string(row) + ": " + e.message();
+            return;
+        } catch (const budget::budget_exception& e) {
+            error = "Invalid row " + to_string(row) + ": " + e.message();
+            return;
+        }
+
+        if (!account_exists(entry.account)) {
+            error = "The account of row " + to_string(row) + " does not exist";
+            return;
+        }
+
+        entry.guid = budget::generate_guid();
+
+        entries.push_back(std::move(entry));
+    });
+
+    if (!error.empty()) {
+        api_error(req, res, error);
+        return false;
+    }
+
+    if (entries.empty()) {
+        api_error(req, res, "Invalid parameters");
+        return false;
+    }
+
+    return true;
+}
+
+std::string batch_ids(const std::vector<size_t>& ids) {
+    std::string content;
+
+    for (auto id : ids) {
+        content += to_string(id);
+        content += '\n';
+    }
+
+    return content;
+}
+
+void batch_expenses_api(const httplib::Request& req, httplib::Response& res) {
+    if (!api_start(req, res)) {
+        return;
+    }
+
+    std::vector<expense> new_expenses;
+
+    if (!parse_account_batch(req, res, new_expenses)) {
+        return;
+    }
+
+    auto ids = add_expenses(std::move(new_expenses));
+
+    api_success(req, res, to_string(ids.size()) + " expenses have been created", batch_ids(ids));
+}
+
+void batch_earnings_api(const httplib::Request& req, httplib::Response& res) {
+    if (!api_start(req, res)) {
+        return;
+    }
+
+    std::vector<earning> new_earnings;
 
-    for (auto& wish : all_wishes()) {
-        ss << wish;
-        ss << std::endl;
+    if (!parse_account_batch(req, res, new_earnings)) {
+        return;
     }
 
-    api_success_content(req, res, ss.str());
+    auto ids = add_earnings(std::move(new_earnings));
+
+    api_success(req, res, to_string(ids.size()) + " earnings have been created", batch_ids(ids));
 }
 
 } //end of anonymous namespace
 
 void budget::load_api(httplib::Server& server) {
-    server.get("/api/server/up/", &server_up_api);
-    server.get("/api/server/version/", &server_version_api);
-    server.post("/api/server/version/support/", &server_version_support_api);
-
-    server.post("/api/accounts/add/", &add_accounts_api);
-    server.post("/api/accounts/edit/", &edit_accounts_api);
-    server.post("/api/accounts/delete/", &delete_accounts_api);
-    server.post("/api/accounts/archive/month/", &archive_accounts_month_api);
-    server.post("/api/accounts/archive/year/", &archive_accounts_year_api);
-    server.get("/api/accounts/list/", &list_accounts_api);
-
-    server.post("/api/expenses/add/", &add_expenses_api);
-    server.post("/api/expenses/edit/", &edit_expenses_api);
-    server.post("/api/expenses/delete/", &delete_expenses_api);
-    server.get("/api/expenses/list/", &list_expenses_api);
-
-    server.post("/api/earnings/add/", &add_earnings_api);
-    server.post("/api/earnings/edit/", &edit_earnings_api);
-    server.post("/api/earnings/delete/", &delete_earnings_api);
-    server.get("/api/earnings/list/", &list_earnings_api);
-
-    server.post("/api/recurrings/add/", &add_recurrings_api);
-    server.post("/api/recurrings/edit/", &edit_recurrings_api);
-    server.post("/api/recurrings/delete/", &delete_recurrings_api);
-    server.get("/api/recurrings/list/", &list_recurrings_api);
-
-    server.post("/api/debts/add/", &add_debts_api);
-    server.post("/api/debts/edit/", &edit_debts_api);
-    server.post("/api/debts/delete/", &delete_debts_api);
-    server.get("/api/debts/list/", &list_debts_api);
-
-    server.post("/api/fortunes/add/", &add_fortunes_api);
-    server.post("/api/fortunes/edit/", &edit_fortunes_api);
-    server.post("/api/fortunes/delete/", &delete_fortunes_api);
-    server.get("/api/fortunes/list/", &list_fortunes_api);
-
-    server.post("/api/wishes/add/", &add_wishes_api);
-    server.post("/api/wishes/edit/", &edit_wishes_api);
-    server.post("/api/wishes/delete/", &delete_wishes_api);
-    server.get("/api/wishes/list/", &list_wishes_api);
-
-    server.post("/api/assets/add/", &add_assets_api);
-    server.post("/api/assets/edit/", &edit_assets_api);
-    server.post("/api/assets/delete/", &delete_assets_api);
-    server.get("/api/assets/list/", &list_assets_api);
-
-    server.post("/api/asset_values/add/", &add_asset_values_api);
-    server.post("/api/asset_values/edit/", &edit_asset_values_api);
-    server.post("/api/asset_values/batch/", &batch_asset_values_api);
-    server.post("/api/asset_values/delete/", &delete_asset_values_api);
-    server.get("/api/asset_values/list/", &list_asset_values_api);
-
-    server.post("/api/retirement/configure/", &retirement_configure_api);
-
-    server.post("/api/objectives/add/", &add_objectives_api);
-    server.post("/api/objectives/edit/", &edit_objectives_api);
-    server.post("/api/objectives/delete/", &delete_objectives_api);
-    server.get("/api/objectives/list/", &list_objectives_api);
+    server.get("/api/server/up/", read_only(&server_up_api));
+    server.get("/api/server/version/", read_only(&server_version_api));
+    server.post("/api/server/version/support/", read_only(&server_version_support_api));
+
+    server.get("/api/sync/", read_only(&sync_api));
+    server.get(R"(/api/(\w+)/changes/)", read_only(&module_changes_api));
+
+    server.post("/api/accounts/add/", read_write(&add_accounts_api));
+    server.post("/api/accounts/edit/", read_write(&edit_accounts_api));
+    server.post("/api/accounts/delete/", read_write(&delete_accounts_api));
+    server.post("/api/accounts/archive/month/", read_write(&archive_accounts_month_api));
+    server.post("/api/accounts/archive/year/", read_write(&archive_accounts_year_api));
+    server.get("/api/accounts/list/", read_only(&list_accounts_api));
+
+    server.post("/api/expenses/add/", read_write(&add_expenses_api));
+    server.post("/api/expenses/edit/", read_write(&edit_expenses_api));
+    server.post("/api/expenses/delete/", read_write(&delete_expenses_api));
+    server.post("/api/expenses/batch/", read_write(&batch_expenses_api));
+    server.get("/api/expenses/list/", read_only(&list_expenses_api));
+
+    server.post("/api/earnings/add/", read_write(&add_earnings_api));
+    server.post("/api/earnings/edit/", read_write(&edit_earnings_api));
+    server.post("/api/earnings/delete/", read_write(&delete_earnings_api));
+    server.post("/api/earnings/batch/", read_write(&batch_earnings_api));
+    server.get("/api/earnings/list/", read_only(&list_earnings_api));
+
+    server.post("/api/recurrings/add/", read_write(&add_recurrings_api));
+    server.post("/api/recurrings/edit/", read_write(&edit_recurrings_api));
+    server.post("/api/recurrings/delete/", read_write(&delete_recurrings_api));
+    server.get("/api/recurrings/list/", read_only(&list_recurrings_api));
+
+    server.post("/api/debts/add/", read_write(&add_debts_api));
+    server.post("/api/debts/edit/", read_write(&edit_debts_api));
+    server.post("/api/debts/delete/", read_write(&delete_debts_api));
+    server.get("/api/debts/list/", read_only(&list_debts_api));
+
+    server.post("/api/fortunes/add/", read_write(&add_fortunes_api));
+    server.post("/api/fortunes/edit/", read_write(&edit_fortunes_api));
+    server.post("/api/fortunes/delete/", read_write(&delete_fortunes_api));
+    server.get("/api/fortunes/list/", read_only(&list_fortunes_api));
+
+    server.post("/api/wishes/add/", read_write(&add_wishes_api));
+    server.post("/api/wishes/edit/", read_write(&edit_wishes_api));
+    server.post("/api/wishes/delete/", read_write(&delete_wishes_api));
+    server.get("/api/wishes/list/", read_only(&list_wishes_api));
+
+    server.post("/api/assets/add/", read_write(&add_assets_api));
+    server.post("/api/assets/edit/", read_write(&edit_assets_api));
+    server.post("/api/assets/delete/", read_write(&delete_assets_api));
+    server.get("/api/assets/list/", read_only(&list_assets_api));
+
+    server.post("/api/asset_values/add/", read_write(&add_asset_values_api));
+    server.post("/api/asset_values/edit/", read_write(&edit_asset_values_api));
+    server.post("/api/asset_values/batch/", read_write(&batch_asset_values_api));
+    server.post("/api/asset_values/delete/", read_write(&delete_asset_values_api));
+    server.get("/api/asset_values/list/", read_only(&list_asset_values_api));
+
+    server.post("/api/retirement/configure/", read_write(&retirement_configure_api));
+
+    server.post("/api/objectives/add/", read_write(&add_objectives_api));
+    server.post("/api/objectives/edit/", read_write(&edit_objectives_api));
+    server.post("/api/objectives/delete/", read_write(&delete_objectives_api));
+    server.get("/api/objectives/list/", read_only(&list_objectives_api));
 }
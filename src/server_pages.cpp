@@ -26,6 +26,9 @@
 #include "retirement.hpp"
 #include "writer.hpp"
 #include "currency.hpp"
+#include "compute.hpp"
+#include "rebalance.hpp"
+#include "server.hpp"
 
 #include "server_pages.hpp"
 #include "http.hpp"
@@ -284,6 +287,7 @@ std::string header(const std::string& title, bool menu = true) {
                   <a class="dropdown-item" href="/retirement/status/">Status</a>
                   <a class="dropdown-item" href="/retirement/configure/">Configure</a>
                   <a class="dropdown-item" href="/retirement/fi/">FI Ratio Over Time</a>
+                  <a class="dropdown-item" href="/retirement/simulate/">Simulation</a>
                 </div>
               </li>
         )=====";
@@ -960,39 +964,11 @@ void make_tables_sortable(budget::html_writer& w){
 }
 
 budget::money monthly_income(budget::month month, budget::year year) {
-    std::map<size_t, budget::money> account_sum;
-
-    for (auto& earning : all_earnings()) {
-        if (earning.date.year() == year && earning.date.month() == month) {
-            account_sum[earning.account] += earning.amount;
-        }
-    }
-
-    budget::money total = get_base_income();
-
-    for (auto& sum : account_sum) {
-        total += sum.second;
-    }
-
-    return total;
+    return get_base_income() + earnings_total(year, month);
 }
 
 budget::money monthly_spending(budget::month month, budget::year year) {
-    std::map<size_t, budget::money> account_sum;
-
-    for (auto& expense : all_expenses()) {
-        if (expense.date.year() == year && expense.date.month() == month) {
-            account_sum[expense.account] += expense.amount;
-        }
-    }
-
-    budget::money total;
-
-    for (auto& sum : account_sum) {
-        total += sum.second;
-    }
-
-    return total;
+    return expenses_total(year, month);
 }
 
 void month_breakdown_income_graph(budget::html_writer& w, const std::string& title, budget::month month, budget::year year, bool mono = false, const std::string& style = "") {
@@ -1024,10 +1000,8 @@ void month_breakdown_income_graph(budget::html_writer& w, const std::string& tit
 
     std::map<size_t, budget::money> account_sum;
 
-    for (auto& earning : all_earnings()) {
-        if (earning.date.year() == year && earning.date.month() == month) {
-            account_sum[earning.account] += earning.amount;
-        }
+    for (auto& earning : all_earnings_month(year, month)) {
+        account_sum[earning.account] += earning.amount;
     }
 
     budget::money total = get_base_income();
@@ -1101,10 +1075,8 @@ void month_breakdown_expenses_graph(budget::html_writer& w, const std::string& t
 
     std::map<size_t, budget::money> account_sum;
 
-    for (auto& expense : all_expenses()) {
-        if (expense.date.year() == year && expense.date.month() == month) {
-            account_sum[expense.account] += expense.amount;
-        }
+    for (auto& expense : all_expenses_month(year, month)) {
+        account_sum[expense.account] += expense.amount;
     }
 
     budget::money total;
@@ -1180,29 +1152,9 @@ void net_worth_graph(budget::html_writer& w, const std::string style = "", bool
     ss << "{ name: 'Net Worth',";
     ss << "data: [";
 
-    std::map<size_t, budget::money> asset_amounts;
-
-    auto sorted_asset_values = all_sorted_asset_values();
-
-    auto it  = sorted_asset_values.begin();
-    auto end = sorted_asset_values.end();
-
-    while (it != end) {
-        auto date = it->set_date;
-
-        while (it->set_date == date) {
-            asset_amounts[it->asset_id] = it->amount * exchange_rate(get_asset(it->asset_id).currency);
-
-            ++it;
-        }
-
-        budget::money sum;
-
-        for (auto& asset : asset_amounts) {
-            sum += asset.second;
-        }
-
-        ss << "[Date.UTC(" << date.year() << "," << date.month().value - 1 << "," << date.day() << ") ," << budget::to_flat_string(sum) << "],";
+    for (auto& point : net_worth_series()) {
+        auto& date = point.date;
+        ss << "[Date.UTC(" << date.year() << "," << date.month().value - 1 << "," << date.day() << ") ," << budget::to_flat_string(point.net_worth) << "],";
     }
 
     ss << "]},";
@@ -1341,24 +1293,6 @@ void objectives_card(budget::html_writer& w){
     w << R"=====(</div>)=====";
 }
 
-std::pair<bool, size_t> find_last_asset_value(size_t asset_id){
-    size_t asset_value_id  = 0;
-    bool asset_value_found = false;
-
-    for (auto& asset_value : all_asset_values()) {
-        if (asset_value.asset_id == asset_id) {
-            if (!asset_value_found) {
-                asset_value_found = true;
-                asset_value_id    = asset_value.id;
-            } else if (asset_value.set_date >= get_asset_value(asset_value_id).set_date) {
-                asset_value_id = asset_value.id;
-            }
-        }
-    }
-
-    return std::make_pair(asset_value_found, asset_value_id);
-}
-
 void assets_card(budget::html_writer& w){
     w << R"=====(<div class="card">)=====";
 
@@ -1489,6 +1423,8 @@ void index_page(const httplib::Request& req, httplib::Response& res) {
     bool left_column = !all_assets().empty() && !all_asset_values().empty();
 
     if (left_column) {
+        prefetch_asset_exchange_rates();
+
         // A. The left column
 
         w << R"=====(<div class="row">)=====";
@@ -1836,13 +1772,7 @@ void time_graph_expenses_page(const httplib::Request& req, httplib::Response& re
         for(unsigned short i = sm; i < last; ++i){
             budget::month month = i;
 
-            budget::money sum;
-
-            for(auto& expense : all_expenses()){
-                if(expense.date.year() == year && expense.date.month() == month){
-                    sum += expense.amount;
-                }
-            }
+            budget::money sum = expenses_total(year, month);
 
             std::string date = "Date.UTC(" + std::to_string(year) + "," + std::to_string(month.value - 1) + ", 1)";
 
@@ -2063,56 +1993,15 @@ void time_graph_savings_rate_page(const httplib::Request& req, httplib::Response
     ss << "{ name: 'Savings Rate',";
     ss << "data: [";
 
-    std::vector<float> serie;
-    std::vector<std::string> dates;
-
-    auto sy = start_year();
-
-    for(unsigned short j = sy; j <= budget::local_day().year(); ++j){
-        budget::year year = j;
-
-        auto sm = start_month(year);
-        auto last = 13;
-
-        if(year == budget::local_day().year()){
-            last = budget::local_day().month() + 1;
-        }
-
-        for(unsigned short i = sm; i < last; ++i){
-            budget::month month = i;
-
-            budget::money income;
-            budget::money expenses;
-
-            for(auto& account : all_accounts(year, month)){
-                income += account.amount;
-            }
-
-            for(auto& earning : all_earnings()){
-                if(earning.date.year() == year && earning.date.month() == month){
-                    income += earning.amount;
-                }
-            }
-
-            for(auto& expense : all_expenses()){
-                if(expense.date.year() == year && expense.date.month() == month){
-                    expenses += expense.amount;
-                }
-            }
-
-            auto savings_rate = (income - expenses) / income;
-
-            if(savings_rate < 0){
-                savings_rate = 0;
-            }
+    auto sy    = start_year();
+    auto today = budget::local_day();
 
-            std::string date = "Date.UTC(" + std::to_string(year) + "," + std::to_string(month.value - 1) + ", 1)";
+    auto history = compute_monthly_history(budget::date(sy, start_month(sy), 1), today);
 
-            serie.push_back(savings_rate);
-            dates.push_back(date);
+    for (size_t i = 0; i < history.size(); ++i) {
+        auto d = history.month_date(i);
 
-            ss << "[" << date << " ," << 100.0 * savings_rate << "],";
-        }
+        ss << "[Date.UTC(" << d.year() << "," << d.month().value - 1 << ", 1) ," << 100.0 * history.savings_rate[i] << "],";
     }
 
     ss << "]},";
@@ -2120,20 +2009,11 @@ void time_graph_savings_rate_page(const httplib::Request& req, httplib::Response
     ss << "{ name: '12 months average',";
     ss << "data: [";
 
-    std::array<float, 12> average_12;
+    for (size_t i = 0; i < history.size(); ++i) {
+        auto d       = history.month_date(i);
+        auto average = history.average_savings_rate(i < 12 ? 0 : i - 11, i + 1);
 
-    for(size_t i = 0; i < serie.size(); ++i){
-        average_12[i % 12] = serie[i];
-
-        auto average = std::accumulate(average_12.begin(), average_12.end(), 0.0f);
-
-        if(i < 12){
-            average = average / float(i + 1);
-        } else {
-            average = average / 12.f;
-        }
-
-        ss << "[" << dates[i] << "," << 100.0 * average << "],";
+        ss << "[Date.UTC(" << d.year() << "," << d.month().value - 1 << ", 1)," << 100.0 * average << "],";
     }
 
     ss << "]},";
@@ -2153,9 +2033,9 @@ void retirement_fi_ratio_over_time(const httplib::Request& req, httplib::Respons
 
     budget::html_writer w(content_stream);
 
-    auto values = all_sorted_asset_values();
+    auto series = net_worth_series();
 
-    if (!values.empty()){
+    if (!series.empty()){
 
         auto ss = start_chart(w, "FI Ratio over time", "line", "fi_time_graph", "");
 
@@ -2171,16 +2051,16 @@ void retirement_fi_ratio_over_time(const httplib::Request& req, httplib::Respons
         std::vector<budget::money> serie;
         std::vector<std::string> dates;
 
-        auto previous = values.front().set_date;
+        auto previous = series.front().date;
 
-        for (size_t i = 0; i < values.size(); ++i) {
-            auto& asset_value = values[i];
-            auto current = asset_value.set_date;
+        for (size_t i = 0; i < series.size(); ++i) {
+            auto& point  = series[i];
+            auto current = point.date;
 
             if (i == 0 || !(previous.month() == current.month() && previous.year() == current.year())) {
                 previous = current;
 
-                auto ratio = budget::fi_ratio(previous);
+                auto ratio = budget::fi_ratio(previous, point.net_worth);
 
                 std::string date = "Date.UTC(" + std::to_string(previous.year()) + "," + std::to_string(previous.month().value - 1) + ", 1)";
                 ss << "[" << date <<  "," << budget::to_string(100 * ratio) << "],";
@@ -2239,11 +2119,7 @@ void time_graph_income_page(const httplib::Request& req, httplib::Response& res)
                 sum += account.amount;
             }
 
-            for(auto& earning : all_earnings()){
-                if(earning.date.year() == year && earning.date.month() == month){
-                    sum += earning.amount;
-                }
-            }
+            sum += earnings_total(year, month);
 
             std::string date = "Date.UTC(" + std::to_string(year) + "," + std::to_string(month.value - 1) + ", 1)";
 
@@ -2318,13 +2194,7 @@ void time_graph_earnings_page(const httplib::Request& req, httplib::Response& re
         for(unsigned short i = sm; i < last; ++i){
             budget::month month = i;
 
-            budget::money sum;
-
-            for(auto& earning : all_earnings()){
-                if(earning.date.year() == year && earning.date.month() == month){
-                    sum += earning.amount;
-                }
-            }
+            budget::money sum = earnings_total(year, month);
 
             ss << "[Date.UTC(" << year << "," << month.value - 1 << ", 1) ," << budget::to_flat_string(sum) << "],";
         }
@@ -2462,6 +2332,8 @@ void portfolio_currency_page(const httplib::Request& req, httplib::Response& res
         return;
     }
 
+    prefetch_asset_exchange_rates();
+
     std::set<std::string> currencies;
 
     for (auto& asset : all_assets()) {
@@ -2501,7 +2373,7 @@ void portfolio_currency_page(const httplib::Request& req, httplib::Response& res
                 auto& asset = get_asset(it->asset_id);
 
                 if (asset.currency == currency && asset.portfolio) {
-                    asset_amounts[it->asset_id] = it->amount * exchange_rate(asset.currency);
+                    asset_amounts[it->asset_id] = convert(it->amount, asset.currency);
                 }
 
                 ++it;
@@ -2545,7 +2417,7 @@ void portfolio_currency_page(const httplib::Request& req, httplib::Response& res
             auto& asset = get_asset(asset_value.asset_id);
 
             if (asset.currency == currency && asset.portfolio) {
-                asset_amounts[asset_value.asset_id] = asset_value.amount * exchange_rate(asset.currency);
+                asset_amounts[asset_value.asset_id] = convert(asset_value.amount, asset.currency);
             }
         }
 
@@ -2575,6 +2447,8 @@ void portfolio_graph_page(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
+    prefetch_asset_exchange_rates();
+
     budget::html_writer w(content_stream);
 
     auto ss = start_chart(w, "Portfolio", "area");
@@ -2592,33 +2466,9 @@ void portfolio_graph_page(const httplib::Request& req, httplib::Response& res) {
     ss << "{ name: 'Portfolio',";
     ss << "data: [";
 
-    std::map<size_t, budget::money> asset_amounts;
-
-    auto sorted_asset_values = all_sorted_asset_values();
-
-    auto it  = sorted_asset_values.begin();
-    auto end = sorted_asset_values.end();
-
-    while (it != end) {
-        auto date = it->set_date;
-
-        while (it->set_date == date) {
-            auto& asset = get_asset(it->asset_id);
-
-            if (asset.portfolio) {
-                asset_amounts[it->asset_id] = it->amount * exchange_rate(asset.currency);
-            }
-
-            ++it;
-        }
-
-        budget::money sum;
-
-        for (auto& asset : asset_amounts) {
-            sum += asset.second;
-        }
-
-        ss << "[Date.UTC(" << date.year() << "," << date.month().value - 1 << "," << date.day() << ") ," << budget::to_flat_string(sum) << "],";
+    for (auto& point : net_worth_series()) {
+        auto& date = point.date;
+        ss << "[Date.UTC(" << date.year() << "," << date.month().value - 1 << "," << date.day() << ") ," << budget::to_flat_string(point.portfolio) << "],";
     }
 
     ss << "]},";
@@ -2636,41 +2486,36 @@ void rebalance_page(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
-    // 1. Display the rebalance table
-
     budget::html_writer w(content_stream);
-    budget::show_asset_rebalance(w);
 
-    make_tables_sortable(w);
+    // 0. Get the new money to invest, if any
 
-    w << R"=====(<div class="row">)=====";
+    budget::money new_money;
 
-    // 2. Display the current allocation
+    if (req.has_param("input_new_money")) {
+        new_money = budget::parse_money(req.get_param_value("input_new_money"));
+    }
 
-    w << R"=====(<div class="col-lg-6 col-md-12">)=====";
+    page_form_begin(w, "/rebalance/");
 
-    // Collect the amounts per asset
+    add_money_picker(w, "New money", "input_new_money", budget::to_flat_string(new_money), true, get_default_currency());
 
-    std::map<size_t, budget::money> asset_amounts;
+    form_end(w, "Rebalance");
 
-    for (auto& asset_value : all_sorted_asset_values()) {
-        if (get_asset(asset_value.asset_id).portfolio) {
-            asset_amounts[asset_value.asset_id] = asset_value.amount;
-        }
-    }
+    // 1. Display the rebalance table
+
+    budget::show_asset_rebalance(w, new_money);
 
-    // Compute the colors for each asset that will be displayed
+    make_tables_sortable(w);
 
-    std::map<size_t, size_t> colors;
+    w << R"=====(<div class="row">)=====";
 
-    for (auto& asset : all_assets()) {
-        if (asset.portfolio && (asset_amounts[asset.id] || asset.portfolio_alloc)) {
-            if (!colors.count(asset.id)) {
-                auto c           = colors.size();
-                colors[asset.id] = c;
-            }
-        }
-    }
+    // 2. Display the current allocation
+
+    w << R"=====(<div class="col-lg-6 col-md-12">)=====";
+
+    auto portfolio = current_portfolio_allocation();
+    auto plan      = full_rebalance(portfolio, new_money);
 
     // Compute the colors for the first graph
 
@@ -2681,9 +2526,9 @@ void rebalance_page(const httplib::Request& req, httplib::Response& res) {
     current_ss << "var current_pie_colors = (function () {";
     current_ss << "var colors = [];";
 
-    for (auto& asset_amount : asset_amounts) {
-        if (asset_amount.second) {
-            current_ss << "colors.push(current_base_colors[" << colors[asset_amount.first] << "]);";
+    for (size_t i = 0; i < portfolio.size(); ++i) {
+        if (portfolio.amounts[i]) {
+            current_ss << "colors.push(current_base_colors[" << i << "]);";
         }
     }
 
@@ -2701,21 +2546,12 @@ void rebalance_page(const httplib::Request& req, httplib::Response& res) {
     ss << "colors: current_pie_colors,";
     ss << "data: [";
 
-    budget::money sum;
-
-    for (auto& asset_amount : asset_amounts) {
-        auto amount = asset_amount.second;
-
-        if (amount) {
-            auto& asset      = get_asset(asset_amount.first);
-            auto conv_amount = amount * exchange_rate(asset.currency);
-
-            ss << "{ name: '" << asset.name << "',";
+    for (size_t i = 0; i < portfolio.size(); ++i) {
+        if (portfolio.amounts[i]) {
+            ss << "{ name: '" << get_asset(portfolio.ids[i]).name << "',";
             ss << "y: ";
-            ss << budget::to_flat_string(conv_amount);
+            ss << budget::to_flat_string(portfolio.values[i]);
             ss << "},";
-
-            sum += conv_amount;
         }
     }
 
@@ -2740,9 +2576,9 @@ void rebalance_page(const httplib::Request& req, httplib::Response& res) {
     desired_ss << "var desired_pie_colors = (function () {";
     desired_ss << "var colors = [];";
 
-    for (auto& asset : all_assets()) {
-        if (asset.portfolio && asset.portfolio_alloc) {
-            desired_ss << "colors.push(desired_base_colors[" << colors[asset.id] << "]);";
+    for (size_t i = 0; i < portfolio.size(); ++i) {
+        if (!portfolio.desired[i].zero()) {
+            desired_ss << "colors.push(desired_base_colors[" << i << "]);";
         }
     }
 
@@ -2762,11 +2598,11 @@ void rebalance_page(const httplib::Request& req, httplib::Response& res) {
     ss2 << "colors: desired_pie_colors,";
     ss2 << "data: [";
 
-    for (auto& asset : all_assets()) {
-        if (asset.portfolio && asset.portfolio_alloc) {
-            ss2 << "{ name: '" << asset.name << "',";
+    for (size_t i = 0; i < portfolio.size(); ++i) {
+        if (!portfolio.desired[i].zero()) {
+            ss2 << "{ name: '" << get_asset(portfolio.ids[i]).name << "',";
             ss2 << "y: ";
-            ss2 << budget::to_flat_string(sum * (static_cast<float>(asset.portfolio_alloc) / 100.0f));
+            ss2 << budget::to_flat_string(plan.targets[i]);
             ss2 << "},";
         }
     }
@@ -2872,6 +2708,8 @@ void net_worth_status_page(const httplib::Request& req, httplib::Response& res)
         return;
     }
 
+    prefetch_asset_exchange_rates();
+
     budget::html_writer w(content_stream);
     budget::show_asset_values(w);
 
@@ -2884,6 +2722,8 @@ void net_worth_small_status_page(const httplib::Request& req, httplib::Response&
         return;
     }
 
+    prefetch_asset_exchange_rates();
+
     budget::html_writer w(content_stream);
     budget::small_show_asset_values(w);
 
@@ -2896,6 +2736,8 @@ void net_worth_graph_page(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
+    prefetch_asset_exchange_rates();
+
     budget::html_writer w(content_stream);
 
     net_worth_graph(w);
@@ -2909,6 +2751,8 @@ void net_worth_allocation_page(const httplib::Request& req, httplib::Response& r
         return;
     }
 
+    prefetch_asset_exchange_rates();
+
     std::vector<std::string> names{"Int. Stocks", "Dom. Stocks", "Bonds", "Cash"};
 
     budget::html_writer w(content_stream);
@@ -2941,7 +2785,7 @@ void net_worth_allocation_page(const httplib::Request& req, httplib::Response& r
             while (it->set_date == date) {
                 auto& asset = get_asset(it->asset_id);
 
-                auto amount = it->amount * exchange_rate(asset.currency);
+                auto amount = convert(it->amount, asset.currency);
 
                 if(i == 0 && asset.int_stocks){
                     asset_amounts[it->asset_id] = amount * (float(asset.int_stocks) / 100.0f);
@@ -2999,7 +2843,7 @@ void net_worth_allocation_page(const httplib::Request& req, httplib::Response& r
         for (auto& asset_value : sorted_asset_values) {
             auto& asset = get_asset(asset_value.asset_id);
 
-            auto amount = asset_value.amount * exchange_rate(asset.currency);
+            auto amount = convert(asset_value.amount, asset.currency);
 
             if(i == 0 && asset.int_stocks){
                 asset_amounts[asset_value.asset_id] = amount * (float(asset.int_stocks) / 100.0f);
@@ -3044,6 +2888,8 @@ void portfolio_allocation_page(const httplib::Request& req, httplib::Response& r
         return;
     }
 
+    prefetch_asset_exchange_rates();
+
     std::vector<std::string> names{"Int. Stocks", "Dom. Stocks", "Bonds", "Cash"};
 
     budget::html_writer w(content_stream);
@@ -3077,7 +2923,7 @@ void portfolio_allocation_page(const httplib::Request& req, httplib::Response& r
                 auto& asset = get_asset(it->asset_id);
 
                 if(asset.portfolio){
-                    auto amount = it->amount * exchange_rate(asset.currency);
+                    auto amount = convert(it->amount, asset.currency);
 
                     if(i == 0 && asset.int_stocks){
                         asset_amounts[it->asset_id] = amount * (float(asset.int_stocks) / 100.0f);
@@ -3137,7 +2983,7 @@ void portfolio_allocation_page(const httplib::Request& req, httplib::Response& r
             auto& asset = get_asset(asset_value.asset_id);
 
             if(asset.portfolio){
-                auto amount = asset_value.amount * exchange_rate(asset.currency);
+                auto amount = convert(asset_value.amount, asset.currency);
 
                 if(i == 0 && asset.int_stocks){
                     asset_amounts[asset_value.asset_id] = amount * (float(asset.int_stocks) / 100.0f);
@@ -3183,6 +3029,8 @@ void net_worth_currency_page(const httplib::Request& req, httplib::Response& res
         return;
     }
 
+    prefetch_asset_exchange_rates();
+
     std::set<std::string> currencies;
 
     for (auto& asset : all_assets()) {
@@ -3220,7 +3068,7 @@ void net_worth_currency_page(const httplib::Request& req, httplib::Response& res
 
             while (it->set_date == date) {
                 if (get_asset(it->asset_id).currency == currency) {
-                    asset_amounts[it->asset_id] = it->amount * exchange_rate(get_asset(it->asset_id).currency);
+                    asset_amounts[it->asset_id] = convert(it->amount, get_asset(it->asset_id).currency);
                 }
 
                 ++it;
@@ -3262,7 +3110,7 @@ void net_worth_currency_page(const httplib::Request& req, httplib::Response& res
 
         for (auto& asset_value : sorted_asset_values) {
             if (get_asset(asset_value.asset_id).currency == currency) {
-                asset_amounts[asset_value.asset_id] = asset_value.amount * exchange_rate(get_asset(asset_value.asset_id).currency);
+                asset_amounts[asset_value.asset_id] = convert(asset_value.amount, get_asset(asset_value.asset_id).currency);
             }
         }
 
@@ -3518,6 +3366,8 @@ void retirement_status_page(const httplib::Request& req, httplib::Response& res)
         return;
     }
 
+    prefetch_asset_exchange_rates();
+
     budget::html_writer w(content_stream);
 
     w << title_begin << "Retirement status" << title_end;
@@ -3539,6 +3389,71 @@ void retirement_status_page(const httplib::Request& req, httplib::Response& res)
     page_end(w, content_stream, req, res);
 }
 
+void retirement_simulate_page(const httplib::Request& req, httplib::Response& res) {
+    std::stringstream content_stream;
+    if (!page_start(req, res, content_stream, "Retirement simulation")) {
+        return;
+    }
+
+    prefetch_asset_exchange_rates();
+
+    budget::html_writer w(content_stream);
+
+    w << title_begin << "Retirement simulation" << title_end;
+
+    if(!internal_config_contains("withdrawal_rate")){
+        display_error_message(w, "Not enough information, please configure Retirement Options first");
+        page_end(w, content_stream, req, res);
+        return;
+    }
+
+    budget::retirement_simulation simulation;
+
+    try {
+        size_t simulations = 10000;
+
+        if (req.has_param("simulations")) {
+            simulations = budget::to_number<size_t>(req.get_param_value("simulations"));
+        } else if (config_contains("retirement_simulations")) {
+            simulations = budget::to_number<size_t>(config_value("retirement_simulations"));
+        }
+
+        simulation = budget::simulate_retirement(simulations);
+    } catch (const budget::budget_exception& e) {
+        display_error_message(w, e.message());
+        page_end(w, content_stream, req, res);
+        return;
+    }
+
+    budget::retirement_simulate(w, simulation);
+
+    auto ss = start_chart(w, "Net Worth when retiring now", "line", "retirement_simulation_graph");
+
+    ss << R"=====(xAxis: { title: { text: 'Year' }},)=====";
+    ss << R"=====(yAxis: { min: 0, title: { text: 'Net Worth' }},)=====";
+
+    ss << "series: [";
+
+    std::array<const char*, 5> names{{"10%", "25%", "Median", "75%", "90%"}};
+
+    for (size_t l = 0; l < names.size(); ++l) {
+        ss << "{ name: '" << names[l] << "',";
+        ss << "data: [";
+
+        for (size_t y = 0; y < simulation.bands.size(); ++y) {
+            ss << "[" << y << "," << budget::to_flat_string(simulation.bands[y][l]) << "],";
+        }
+
+        ss << "]},";
+    }
+
+    ss << "]";
+
+    end_chart(w, ss);
+
+    page_end(w, content_stream, req, res);
+}
+
 void retirement_configure_page(const httplib::Request& req, httplib::Response& res) {
     std::stringstream content_stream;
     if (!page_start(req, res, content_stream, "Retirement configure")) {
@@ -3951,101 +3866,102 @@ void edit_debts_page(const httplib::Request& req, httplib::Response& res) {
 
 void budget::load_pages(httplib::Server& server) {
     // Declare all the pages
-    server.get("/", &index_page);
-
-    server.get("/overview/year/", &overview_year_page);
-    server.get(R"(/overview/year/(\d+)/)", &overview_year_page);
-    server.get("/overview/", &overview_page);
-    server.get(R"(/overview/(\d+)/(\d+)/)", &overview_page);
-    server.get("/overview/aggregate/year/", &overview_aggregate_year_page);
-    server.get(R"(/overview/aggregate/year/(\d+)/)", &overview_aggregate_year_page);
-    server.get("/overview/aggregate/month/", &overview_aggregate_month_page);
-    server.get(R"(/overview/aggregate/month/(\d+)/(\d+)/)", &overview_aggregate_month_page);
-    server.get("/overview/aggregate/all/", &overview_aggregate_all_page);
-    server.get("/overview/savings/time/", &time_graph_savings_rate_page);
-
-    server.get("/report/", &report_page);
-
-    server.get("/accounts/", &accounts_page);
-    server.get("/accounts/all/", &all_accounts_page);
-    server.get("/accounts/add/", &add_accounts_page);
-    server.post("/accounts/edit/", &edit_accounts_page);
-    server.get("/accounts/archive/month/", &archive_accounts_month_page);
-    server.get("/accounts/archive/year/", &archive_accounts_year_page);
-
-    server.get(R"(/expenses/(\d+)/(\d+)/)", &expenses_page);
-    server.get("/expenses/", &expenses_page);
-    server.get("/expenses/search/", &search_expenses_page);
-
-    server.get(R"(/expenses/breakdown/month/(\d+)/(\d+)/)", &month_breakdown_expenses_page);
-    server.get("/expenses/breakdown/month/", &month_breakdown_expenses_page);
-
-    server.get(R"(/expenses/breakdown/year/(\d+)/)", &year_breakdown_expenses_page);
-    server.get("/expenses/breakdown/year/", &year_breakdown_expenses_page);
-
-    server.get("/expenses/time/", &time_graph_expenses_page);
-    server.get("/expenses/all/", &all_expenses_page);
-    server.get("/expenses/add/", &add_expenses_page);
-    server.post("/expenses/edit/", &edit_expenses_page);
-
-    server.get(R"(/earnings/(\d+)/(\d+)/)", &earnings_page);
-    server.get("/earnings/", &earnings_page);
-
-    server.get("/earnings/time/", &time_graph_earnings_page);
-    server.get("/income/time/", &time_graph_income_page);
-    server.get("/earnings/all/", &all_earnings_page);
-    server.get("/earnings/add/", &add_earnings_page);
-    server.post("/earnings/edit/", &edit_earnings_page);
-
-    server.get("/portfolio/status/", &portfolio_status_page);
-    server.get("/portfolio/graph/", &portfolio_graph_page);
-    server.get("/portfolio/currency/", &portfolio_currency_page);
-    server.get("/portfolio/allocation/", &portfolio_allocation_page);
-    server.get("/rebalance/", &rebalance_page);
-    server.get("/assets/", &assets_page);
-    server.get("/net_worth/status/", &net_worth_status_page);
-    server.get("/net_worth/status/small/", &net_worth_small_status_page); // Not in the menu for now
-    server.get("/net_worth/graph/", &net_worth_graph_page);
-    server.get("/net_worth/currency/", &net_worth_currency_page);
-    server.get("/net_worth/allocation/", &net_worth_allocation_page);
-    server.get("/assets/add/", &add_assets_page);
-    server.post("/assets/edit/", &edit_assets_page);
-
-    server.get("/asset_values/list/", &list_asset_values_page);
-    server.get("/asset_values/add/", &add_asset_values_page);
-    server.get("/asset_values/batch/full/", &full_batch_asset_values_page);
-    server.get("/asset_values/batch/current/", &current_batch_asset_values_page);
-    server.post("/asset_values/edit/", &edit_asset_values_page);
-
-    server.get("/objectives/list/", &list_objectives_page);
-    server.get("/objectives/status/", &status_objectives_page);
-    server.get("/objectives/add/", &add_objectives_page);
-    server.post("/objectives/edit/", &edit_objectives_page);
-
-    server.get("/wishes/list/", &wishes_list_page);
-    server.get("/wishes/status/", &wishes_status_page);
-    server.get("/wishes/estimate/", &wishes_estimate_page);
-    server.get("/wishes/add/", &add_wishes_page);
-    server.post("/wishes/edit/", &edit_wishes_page);
-
-    server.get("/retirement/status/", &retirement_status_page);
-    server.get("/retirement/configure/", &retirement_configure_page);
-    server.get("/retirement/fi/", &retirement_fi_ratio_over_time);
-
-    server.get("/recurrings/list/", &recurrings_list_page);
-    server.get("/recurrings/add/", &add_recurrings_page);
-    server.post("/recurrings/edit/", &edit_recurrings_page);
-
-    server.get("/debts/list/", &list_debts_page);
-    server.get("/debts/all/", &all_debts_page);
-    server.get("/debts/add/", &add_debts_page);
-    server.post("/debts/edit/", &edit_debts_page);
-
-    server.get("/fortunes/graph/", &graph_fortunes_page);
-    server.get("/fortunes/status/", &status_fortunes_page);
-    server.get("/fortunes/list/", &list_fortunes_page);
-    server.get("/fortunes/add/", &add_fortunes_page);
-    server.post("/fortunes/edit/", &edit_fortunes_page);
+    server.get("/", read_only(&index_page));
+
+    server.get("/overview/year/", read_only(&overview_year_page));
+    server.get(R"(/overview/year/(\d+)/)", read_only(&overview_year_page));
+    server.get("/overview/", read_only(&overview_page));
+    server.get(R"(/overview/(\d+)/(\d+)/)", read_only(&overview_page));
+    server.get("/overview/aggregate/year/", read_only(&overview_aggregate_year_page));
+    server.get(R"(/overview/aggregate/year/(\d+)/)", read_only(&overview_aggregate_year_page));
+    server.get("/overview/aggregate/month/", read_only(&overview_aggregate_month_page));
+    server.get(R"(/overview/aggregate/month/(\d+)/(\d+)/)", read_only(&overview_aggregate_month_page));
+    server.get("/overview/aggregate/all/", read_only(&overview_aggregate_all_page));
+    server.get("/overview/savings/time/", read_only(&time_graph_savings_rate_page));
+
+    server.get("/report/", read_only(&report_page));
+
+    server.get("/accounts/", read_only(&accounts_page));
+    server.get("/accounts/all/", read_only(&all_accounts_page));
+    server.get("/accounts/add/", read_only(&add_accounts_page));
+    server.post("/accounts/edit/", read_only(&edit_accounts_page));
+    server.get("/accounts/archive/month/", read_only(&archive_accounts_month_page));
+    server.get("/accounts/archive/year/", read_only(&archive_accounts_year_page));
+
+    server.get(R"(/expenses/(\d+)/(\d+)/)", read_only(&expenses_page));
+    server.get("/expenses/", read_only(&expenses_page));
+    server.get("/expenses/search/", read_only(&search_expenses_page));
+
+    server.get(R"(/expenses/breakdown/month/(\d+)/(\d+)/)", read_only(&month_breakdown_expenses_page));
+    server.get("/expenses/breakdown/month/", read_only(&month_breakdown_expenses_page));
+
+    server.get(R"(/expenses/breakdown/year/(\d+)/)", read_only(&year_breakdown_expenses_page));
+    server.get("/expenses/breakdown/year/", read_only(&year_breakdown_expenses_page));
+
+    server.get("/expenses/time/", read_only(&time_graph_expenses_page));
+    server.get("/expenses/all/", read_only(&all_expenses_page));
+    server.get("/expenses/add/", read_only(&add_expenses_page));
+    server.post("/expenses/edit/", read_only(&edit_expenses_page));
+
+    server.get(R"(/earnings/(\d+)/(\d+)/)", read_only(&earnings_page));
+    server.get("/earnings/", read_only(&earnings_page));
+
+    server.get("/earnings/time/", read_only(&time_graph_earnings_page));
+    server.get("/income/time/", read_only(&time_graph_income_page));
+    server.get("/earnings/all/", read_only(&all_earnings_page));
+    server.get("/earnings/add/", read_only(&add_earnings_page));
+    server.post("/earnings/edit/", read_only(&edit_earnings_page));
+
+    server.get("/portfolio/status/", read_only(&portfolio_status_page));
+    server.get("/portfolio/graph/", read_only(&portfolio_graph_page));
+    server.get("/portfolio/currency/", read_only(&portfolio_currency_page));
+    server.get("/portfolio/allocation/", read_only(&portfolio_allocation_page));
+    server.get("/rebalance/", read_only(&rebalance_page));
+    server.get("/assets/", read_only(&assets_page));
+    server.get("/net_worth/status/", read_only(&net_worth_status_page));
+    server.get("/net_worth/status/small/", read_only(&net_worth_small_status_page)); // Not in the menu for now
+    server.get("/net_worth/graph/", read_only(&net_worth_graph_page));
+    server.get("/net_worth/currency/", read_only(&net_worth_currency_page));
+    server.get("/net_worth/allocation/", read_only(&net_worth_allocation_page));
+    server.get("/assets/add/", read_only(&add_assets_page));
+    server.post("/assets/edit/", read_only(&edit_assets_page));
+
+    server.get("/asset_values/list/", read_only(&list_asset_values_page));
+    server.get("/asset_values/add/", read_only(&add_asset_values_page));
+    server.get("/asset_values/batch/full/", read_only(&full_batch_asset_values_page));
+    server.get("/asset_values/batch/current/", read_only(&current_batch_asset_values_page));
+    server.post("/asset_values/edit/", read_only(&edit_asset_values_page));
+
+    server.get("/objectives/list/", read_only(&list_objectives_page));
+    server.get("/objectives/status/", read_only(&status_objectives_page));
+    server.get("/objectives/add/", read_only(&add_objectives_page));
+    server.post("/objectives/edit/", read_only(&edit_objectives_page));
+
+    server.get("/wishes/list/", read_only(&wishes_list_page));
+    server.get("/wishes/status/", read_only(&wishes_status_page));
+    server.get("/wishes/estimate/", read_only(&wishes_estimate_page));
+    server.get("/wishes/add/", read_only(&add_wishes_page));
+    server.post("/wishes/edit/", read_only(&edit_wishes_page));
+
+    server.get("/retirement/status/", read_only(&retirement_status_page));
+    server.get("/retirement/configure/", read_only(&retirement_configure_page));
+    server.get("/retirement/fi/", read_only(&retirement_fi_ratio_over_time));
+    server.get("/retirement/simulate/", read_only(&retirement_simulate_page));
+
+    server.get("/recurrings/list/", read_only(&recurrings_list_page));
+    server.get("/recurrings/add/", read_only(&add_recurrings_page));
+    server.post("/recurrings/edit/", read_only(&edit_recurrings_page));
+
+    server.get("/debts/list/", read_only(&list_debts_page));
+    server.get("/debts/all/", read_only(&all_debts_page));
+    server.get("/debts/add/", read_only(&add_debts_page));
+    server.post("/debts/edit/", read_only(&edit_debts_page));
+
+    server.get("/fortunes/graph/", read_only(&graph_fortunes_page));
+    server.get("/fortunes/status/", read_only(&status_fortunes_page));
+    server.get("/fortunes/list/", read_only(&list_fortunes_page));
+    server.get("/fortunes/add/", read_only(&add_fortunes_page));
+    server.post("/fortunes/edit/", read_only(&edit_fortunes_page));
 
     // Handle error
 
@@ -0,0 +1,256 @@
+//=======================================================================
+// Copyright (c) 2013-2018 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <cstring>
+#include <fstream>
+
+#include <sys/stat.h>
+
+#include "snapshot.hpp"
+#include "config.hpp"
+
+using namespace budget;
+
+namespace {
+
+// The header is made of the magic, the stamp of the data file and the
+// number of rows, columns and strings
+constexpr const char magic[8] = {'B', 'U', 'D', 'G', 'E', 'T', 'S', '2'};
+constexpr const size_t stamp_size  = 2 * sizeof(uint64_t);
+constexpr const size_t header_size = sizeof(magic) + stamp_size + 3 * sizeof(uint64_t);
+
+uint64_t read_u64(const char* p){
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+} // end of anonymous namespace
+
+bool budget::get_file_stamp(const std::string& path, file_stamp& stamp){
+    struct stat sb;
+
+    if (stat(path.c_str(), &sb) != 0) {
+        return false;
+    }
+
+    stamp.size = sb.st_size;
+
+#if defined(__APPLE__)
+    stamp.mtime = uint64_t(sb.st_mtimespec.tv_sec) * 1000000000 + sb.st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+    stamp.mtime = uint64_t(sb.st_mtime) * 1000000000;
+#else
+    stamp.mtime = uint64_t(sb.st_mtim.tv_sec) * 1000000000 + sb.st_mtim.tv_nsec;
+#endif
+
+    return true;
+}
+
+void budget::snapshot_writer::push(int64_t value){
+    if (rows == 0) {
+        columns.emplace_back();
+    }
+
+    columns[column++].push_back(value);
+}
+
+snapshot_writer& budget::snapshot_writer::operator<<(int64_t value){
+    push(value);
+    return *this;
+}
+
+snapshot_writer& budget::snapshot_writer::operator<<(const std::string& value){
+    auto it = string_ids.find(value);
+
+    if (it == string_ids.end()) {
+        it = string_ids.emplace(value, strings.size()).first;
+        strings.push_back(value);
+    }
+
+    push(it->second);
+    return *this;
+}
+
+snapshot_writer& budget::snapshot_writer::operator<<(const budget::date& value){
+    push(value.year() * 10000 + value.month() * 100 + value.day());
+    return *this;
+}
+
+snapshot_writer& budget::snapshot_writer::operator<<(const budget::money& value){
+    push(value.value);
+    return *this;
+}
+
+void budget::snapshot_writer::next_row(){
+    ++rows;
+    column = 0;
+}
+
+bool budget::snapshot_writer::write(const std::string& path, const file_stamp& stamp) const {
+    auto tmp_path = path + ".tmp";
+
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+
+    if (!file.is_open()) {
+        return false;
+    }
+
+    uint64_t header[5] = {stamp.size, stamp.mtime, rows, columns.size(), strings.size()};
+
+    file.write(magic, sizeof(magic));
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    for (auto& values : columns) {
+        file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(int64_t));
+    }
+
+    for (auto& value : strings) {
+        uint32_t length = value.size();
+        file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        file.write(value.data(), length);
+    }
+
+    file.close();
+
+    // The snapshot can always be rebuilt from the data file, no need to sync it
+    return file.good() && replace_file(tmp_path, path, false);
+}
+
+budget::snapshot_reader::snapshot_reader(const std::string& path) : file(path) {
+    auto first = file.begin();
+    auto last  = file.end();
+
+    if (file.size() < header_size || std::memcmp(first, magic, sizeof(magic)) != 0) {
+        return;
+    }
+
+    rows               = read_u64(first + sizeof(magic) + stamp_size);
+    uint64_t n_columns = read_u64(first + sizeof(magic) + stamp_size + 8);
+    uint64_t n_strings = read_u64(first + sizeof(magic) + stamp_size + 16);
+
+    // Make sure the columns fit in the file
+    auto available = (file.size() - header_size) / sizeof(int64_t);
+
+    if (rows > available || (rows && n_columns > available / rows) || n_strings > file.size()) {
+        return;
+    }
+
+    auto current = first + header_size;
+
+    for (size_t c = 0; c < n_columns; ++c) {
+        columns.push_back(current);
+        current += rows * sizeof(int64_t);
+    }
+
+    strings.reserve(n_strings);
+
+    for (size_t s = 0; s < n_strings; ++s) {
+        uint32_t length;
+
+        if (size_t(last - current) < sizeof(length)) {
+            return;
+        }
+
+        std::memcpy(&length, current, sizeof(length));
+        current += sizeof(length);
+
+        if (size_t(last - current) < length) {
+            return;
+        }
+
+        strings.emplace_back(current, length);
+        current += length;
+    }
+
+    valid = current == last;
+}
+
+int64_t budget::snapshot_reader::pop(){
+    // Reading more values than there are columns means the snapshot does
+    // not match the current version of the entries
+    if (column >= columns.size() || row >= rows) {
+        valid = false;
+        return 0;
+    }
+
+    int64_t value;
+    std::memcpy(&value, columns[column++] + row * sizeof(int64_t), sizeof(value));
+    return value;
+}
+
+snapshot_reader& budget::snapshot_reader::operator>>(int64_t& value){
+    value = pop();
+    return *this;
+}
+
+snapshot_reader& budget::snapshot_reader::operator>>(std::string& value){
+    auto id = pop();
+
+    if (id < 0 || size_t(id) >= strings.size()) {
+        valid = false;
+        return *this;
+    }
+
+    value.assign(strings[id].first, strings[id].second);
+    return *this;
+}
+
+snapshot_reader& budget::snapshot_reader::operator>>(budget::date& value){
+    auto v = pop();
+
+    try {
+        value = budget::date(v / 10000, (v / 100) % 100, v % 100);
+    } catch (const budget::date_exception&) {
+        valid = false;
+    }
+
+    return *this;
+}
+
+snapshot_reader& budget::snapshot_reader::operator>>(budget::money& value){
+    value.value = pop();
+    return *this;
+}
+
+void budget::snapshot_reader::next_row(){
+    // All the columns must have been read
+    if (column != columns.size()) {
+        valid = false;
+    }
+
+    ++row;
+    column = 0;
+}
+
+bool budget::is_snapshot_enabled(){
+    return config_contains_and_true("data_snapshots");
+}
+
+std::string budget::snapshot_path(const std::string& file_path){
+    return file_path + ".snapshot";
+}
+
+bool budget::is_snapshot_fresh(const std::string& file_path){
+    file_stamp stamp;
+
+    if (!get_file_stamp(file_path, stamp)) {
+        return false;
+    }
+
+    std::ifstream file(snapshot_path(file_path), std::ios::binary);
+
+    char header[sizeof(magic) + stamp_size];
+
+    if (!file.read(header, sizeof(header)) || std::memcmp(header, magic, sizeof(magic)) != 0) {
+        return false;
+    }
+
+    // Any modification of the data file, even in the same second, changes
+    // its stamp
+    return read_u64(header + sizeof(magic)) == stamp.size && read_u64(header + sizeof(magic) + 8) == stamp.mtime;
+}
@@ -6,6 +6,7 @@
 //=======================================================================
 
 #include <cstdio>
+#include <cstdlib>
 #include <fstream>
 
 #include <unistd.h>
@@ -13,8 +14,10 @@
 #include <windows.h>
 #else
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #endif
 #include <sys/stat.h>
+#include <fcntl.h>
 
 #include "cpp_utils/assert.hpp"
 
@@ -66,6 +69,122 @@ bool budget::folder_exists(const std::string& name){
     return stat(name.c_str(), &sb) == 0 && S_ISDIR(sb.st_mode);
 }
 
+bool budget::sync_file(const std::string& path){
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    bool synced = fsync(fd) == 0;
+
+    close(fd);
+
+    return synced;
+#else
+    cpp_unused(path);
+    return true;
+#endif
+}
+
+std::string budget::resolve_path(const std::string& path){
+#ifndef _WIN32
+    char* resolved = realpath(path.c_str(), nullptr);
+
+    if (resolved) {
+        std::string resolved_path(resolved);
+        free(resolved);
+        return resolved_path;
+    }
+#endif
+
+    return path;
+}
+
+bool budget::replace_file(const std::string& tmp_path, const std::string& path, bool sync){
+    if (sync && !sync_file(tmp_path)) {
+        return false;
+    }
+
+#ifdef _WIN32
+    // rename does not replace an existing file
+    std::remove(path.c_str());
+#else
+    // The new file keeps the owner and the permissions of the replaced file
+    struct stat sb;
+
+    if (stat(path.c_str(), &sb) == 0) {
+        if (chown(tmp_path.c_str(), sb.st_uid, sb.st_gid) != 0) {
+            // Only the superuser can give the file to another user, the
+            // current user stays the owner of the file in that case
+        }
+
+        chmod(tmp_path.c_str(), sb.st_mode & 07777);
+    }
+#endif
+
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        return false;
+    }
+
+    if (sync) {
+        // The rename is only durable once the folder is flushed
+        auto separator = path.find_last_of('/');
+
+        return sync_file(separator == std::string::npos ? "." : path.substr(0, separator));
+    }
+
+    return true;
+}
+
+budget::mapped_file::mapped_file(const std::string& path){
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+
+    if (fd >= 0) {
+        struct stat sb;
+
+        if (fstat(fd, &sb) == 0 && sb.st_size > 0) {
+            void* address = mmap(nullptr, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (address != MAP_FAILED) {
+                madvise(address, sb.st_size, MADV_SEQUENTIAL);
+
+                first  = static_cast<const char*>(address);
+                length = sb.st_size;
+                mapped = true;
+            }
+        }
+
+        close(fd);
+
+        if (mapped) {
+            return;
+        }
+    }
+#endif
+
+    // Fallback to reading the complete file
+
+    std::ifstream file(path, std::ios::binary);
+
+    if (file.is_open()) {
+        buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    first  = buffer.data();
+    length = buffer.size();
+}
+
+budget::mapped_file::~mapped_file(){
+#ifndef _WIN32
+    if (mapped) {
+        munmap(const_cast<char*>(first), length);
+    }
+#endif
+}
+
 std::vector<std::string>& budget::split(const std::string& s, char delim, std::vector<std::string>& elems) {
     std::stringstream ss(s);
     std::string item;